@@ -1,22 +1,172 @@
 #include <iostream>
 #include <fstream>
 #include <vector>
+#include <array>
 #include <string>
 #include <map>
-#include <queue>
+#include <unordered_map>
+#include <memory>
+#include <new>
 #include <sstream>
 #include <iomanip>
 #include <algorithm>
+#include <functional>
 #include <cstdlib>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <limits>
 #include <ctime>
+#include <random>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 using namespace std;
 
+// Alocacoes dinamicas feitas pela thread corrente (lido no modo --count-allocs).
+// Substituir o operator new global custa um incremento por alocacao.
+thread_local long long allocation_count = 0;
+
+void* operator new(size_t size) {
+    allocation_count++;
+    if (void* block = malloc(size ? size : 1)) return block;
+    throw bad_alloc();
+}
+
+// O GCC confunde este free() (par do malloc acima) com liberar memoria de new
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void operator delete(void* block) noexcept { free(block); }
+void operator delete(void* block, size_t) noexcept { free(block); }
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
 // Tipos de operacao
 enum OpType {
-    ADD, SUB, MUL, DIV, LOAD, STORE
+    ADD, SUB, MUL, DIV, LOAD, STORE, BRANCH
+};
+
+const int NUM_OPS = BRANCH + 1;
+
+// Condicao de um desvio (BRANCH): compara os dois registradores fonte
+enum BranchCondition {
+    BRANCH_EQ, BRANCH_NE, BRANCH_LT, BRANCH_GE
+};
+
+const int NUM_BRANCH_CONDITIONS = BRANCH_GE + 1;
+const char* const BRANCH_NAMES[NUM_BRANCH_CONDITIONS] = {"BEQ", "BNE", "BLT", "BGE"};
+
+// Classes de estacoes de reserva
+enum StationClass {
+    ADD_CLASS, MULT_CLASS, LOAD_CLASS, STORE_CLASS
+};
+
+const int NUM_STATION_CLASSES = STORE_CLASS + 1;
+const char* const STATION_CLASS_NAMES[NUM_STATION_CLASSES] = {"add", "mult", "load", "store"};
+
+StationClass stationClassOf(OpType op) {
+    switch (op) {
+        case ADD:
+        case SUB: return ADD_CLASS;
+        case MUL:
+        case DIV: return MULT_CLASS;
+        case LOAD: return LOAD_CLASS;
+        case STORE: return STORE_CLASS;
+        case BRANCH: return ADD_CLASS; // Desvios usam a ULA inteira
+    }
+    return ADD_CLASS;
+}
+
+// Tipos de unidade funcional. As estacoes so guardam instrucoes; a execucao
+// ocupa uma unidade do tipo da operacao (ver FunctionalUnits)
+enum FuKind {
+    FU_ALU, FU_MUL, FU_DIV, FU_MEM
+};
+
+const int NUM_FU_KINDS = FU_MEM + 1;
+const char* const FU_KIND_NAMES[NUM_FU_KINDS] = {"alu", "mul", "div", "mem"};
+
+FuKind fuKindOf(OpType op) {
+    switch (op) {
+        case ADD:
+        case SUB:
+        case BRANCH: return FU_ALU;
+        case MUL: return FU_MUL;
+        case DIV: return FU_DIV;
+        case LOAD:
+        case STORE: return FU_MEM;
+    }
+    return FU_ALU;
+}
+
+// Motivo pelo qual nenhuma instrucao foi emitida no ciclo
+enum IssueStall {
+    STALL_NONE, STALL_FETCH_EMPTY, STALL_ROB_FULL, STALL_NO_STATION
 };
 
+// Tag nula: operando pronto / registrador sem produtor pendente
+const int NO_TAG = -1;
+
+// Banco de registradores: R0-R31 (ids 0-31) seguidos de F0-F31 (ids 32-63)
+const int REGS_PER_BANK = 32;
+const int NUM_REGS = 2 * REGS_PER_BANK;
+const int NO_REG = -1; // Operando que nao e registrador (ex.: "0(R1)" ou imediato)
+
+// Endereco de palavra de LOAD/STORE; negativo = invalido (falha de acesso)
+typedef int64_t Address;
+
+// offset + valor do registrador base, truncado para inteiro. Um valor base
+// fora da faixa de 64 bits (ou NaN) da um endereco invalido.
+Address effectiveAddress(int offset, float base_value) {
+    if (!(base_value > -9.2e18f && base_value < 9.2e18f)) return -1;
+    return static_cast<Address>(offset) + static_cast<Address>(base_value);
+}
+
+// Converter nome ("R5", "F12") em id do banco; NO_REG se nao for registrador.
+// Recebe um trecho [begin, end) da linha e ignora virgulas ("F2," == "F2").
+int parseRegister(const char* begin, const char* end) {
+    char bank = 0;
+    int num = 0;
+    int digits = 0;
+    for (const char* c = begin; c < end; c++) {
+        if (*c == ',') continue;
+        if (!bank) {
+            if (*c != 'R' && *c != 'F') return NO_REG;
+            bank = *c;
+            continue;
+        }
+        if (!isdigit(static_cast<unsigned char>(*c))) return NO_REG;
+        num = num * 10 + (*c - '0');
+        if (num >= REGS_PER_BANK) return NO_REG;
+        digits++;
+    }
+    if (digits == 0) return NO_REG;
+    return (bank == 'F' ? REGS_PER_BANK : 0) + num;
+}
+
+int parseRegister(const string& name) {
+    return parseRegister(name.data(), name.data() + name.size());
+}
+
+string registerName(int reg) {
+    if (reg == NO_REG) return "-";
+    return (reg < REGS_PER_BANK ? "R" : "F") + to_string(reg % REGS_PER_BANK);
+}
+
 // Estado da instrucao
 enum InstrState {
     ISSUED, EXECUTING, WRITE_RESULT, COMMITTED
@@ -24,732 +174,5515 @@ enum InstrState {
 
 // Estrutura da instrucao
 struct Instruction {
-    int id;
+    long long id;
     OpType op;
-    string dest;
-    string src1;
-    string src2;
-    int address; // Para LOAD/STORE
+    int dest;     // Id do registrador destino (dado a ser escrito no STORE)
+    int src1;
+    int src2;
+    int offset;   // Para LOAD/STORE no formato offset(Rbase)
+    int base_reg; // Registrador base do endereco (NO_REG se ausente)
+    long long pc; // Posicao no programa (indice da instrucao, alvo dos desvios)
+    BranchCondition cond; // BRANCH: condicao
+    long long target;     // BRANCH: pc do rotulo alvo
+    uint64_t history;     // Historico global do preditor na busca (recuperacao)
+    bool predicted_taken; // BRANCH: previsao feita na busca
+    bool btb_miss;        // BRANCH: previsto tomado sem alvo no BTB (seguiu em frente)
+    bool mispredicted;    // BRANCH: resolvido diferente da previsao
+    long long producers[2]; // ids das instrucoes que produzem os operandos na emissao (0 = pronto)
+    long long seq;        // Numero unico da busca, em ordem de programa (--pipeview)
     InstrState state;
-    int issue_cycle;
-    int exec_start_cycle;
-    int exec_end_cycle;
-    int write_cycle;
-    int commit_cycle;  // Adicionado campo commit_cycle
+    long long fetch_cycle;
+    long long issue_cycle;
+    long long exec_start_cycle;
+    long long exec_end_cycle;
+    long long write_cycle;
+    long long commit_cycle;  // Adicionado campo commit_cycle
     
-    Instruction(int _id, OpType _op, string _dest, string _src1, string _src2 = "", int _addr = 0)
-        : id(_id), op(_op), dest(_dest), src1(_src1), src2(_src2), address(_addr), 
-          state(ISSUED), issue_cycle(-1), exec_start_cycle(-1), exec_end_cycle(-1), 
-          write_cycle(-1), commit_cycle(-1) {}
+    Instruction() : Instruction(0, ADD, NO_REG, NO_REG) {}
+    Instruction(long long _id, OpType _op, int _dest, int _src1, int _src2 = NO_REG,
+                int _offset = 0, int _base_reg = NO_REG)
+        : id(_id), op(_op), dest(_dest), src1(_src1), src2(_src2), offset(_offset), base_reg(_base_reg), 
+          pc(0), cond(BRANCH_EQ), target(-1), history(0), predicted_taken(false), btb_miss(false),
+          mispredicted(false), producers{0, 0}, seq(0), state(ISSUED), fetch_cycle(-1), issue_cycle(-1), exec_start_cycle(-1),
+          exec_end_cycle(-1), write_cycle(-1), commit_cycle(-1) {}
 };
 
-// Estação de reserva
-struct ReservationStation {
-    bool busy;
-    OpType op;
-    int instr_id;
-    string vj, vk; // Valores dos operandos
-    string qj, qk; // Tags das estações produtoras
-    string dest;   // Registrador destino
-    int dest_reg;  // Número do registrador destino
-    int cycles_left; // Ciclos restantes para execução
-    int address; // Para LOAD/STORE
+// Indice do bit menos significativo ligado (mask != 0)
+inline int lowestBit(uint64_t mask) {
+#if defined(__GNUC__)
+    return __builtin_ctzll(mask);
+#else
+    int bit = 0;
+    while (!(mask & 1)) {
+        mask >>= 1;
+        bit++;
+    }
+    return bit;
+#endif
+}
+
+// Reiniciar um vetor de estado com n elementos iguais a value. O vector de
+// RuntimeMachine e redimensionado; o array de StaticMachine ja tem o tamanho.
+template <class T>
+void resetArray(vector<T>& storage, size_t n, const T& value) {
+    storage.assign(n, value);
+}
+
+template <class T, size_t N>
+void resetArray(array<T, N>& storage, size_t, const T& value) {
+    storage.fill(value);
+}
+
+// Prefixo dos nomes das estacoes na impressao ("Add1", "Mult2", ...)
+const char* const STATION_PREFIXES[NUM_STATION_CLASSES] = {"Add", "Mult", "Load", "Store"};
+
+// Estacoes de reserva de todas as classes numa tabela unica no formato SoA
+// (structure of arrays): cada campo e um vetor contiguo indexado pela estacao,
+// e as estacoes da classe c ocupam [class_begin[c], class_begin[c + 1]).
+// Ocupacao e consumidores de cada tag sao mascaras de bits (64 estacoes por
+// palavra): o broadcast visita so os bits ligados em vez de varrer estacoes.
+// Tamanhos e limites de classe vem de Machine (ver RuntimeMachine/StaticMachine).
+template <class Machine>
+struct StationTable {
+    static const size_t CAPACITY = Machine::MAX_STATIONS;
+    static const size_t WORDS = (CAPACITY + 63) / 64;
+    
+    Machine machine;
+    typename Machine::template Array<uint64_t, WORDS> busy; // Bit i: estacao i ocupada
+    typename Machine::template Array<OpType, CAPACITY> op;
+    typename Machine::template Array<long long, CAPACITY> instr_id;
+    typename Machine::template Array<float, CAPACITY> vj, vk; // Valores dos operandos
+    typename Machine::template Array<int, CAPACITY> qj, qk;   // Tags do ROB produtoras (NO_TAG se o valor ja esta em vj/vk)
+    typename Machine::template Array<int, CAPACITY> dest;     // Tag do ROB destino
+    typename Machine::template Array<int, CAPACITY> dest_reg; // Registrador destino
+    typename Machine::template Array<Address, CAPACITY> address; // Para LOAD/STORE
+    
+    void init(const Machine& parameters) {
+        machine = parameters;
+        int n = size();
+        resetArray(busy, words(), uint64_t(0));
+        resetArray(op, n, ADD);
+        resetArray(instr_id, n, -1LL);
+        resetArray(vj, n, 0.0f);
+        resetArray(vk, n, 0.0f);
+        resetArray(qj, n, NO_TAG);
+        resetArray(qk, n, NO_TAG);
+        resetArray(dest, n, NO_TAG);
+        resetArray(dest_reg, n, NO_REG);
+        resetArray(address, n, Address(0));
+    }
+    
+    int classBegin(int c) const { return machine.classBegin(c); }
+    int size() const { return machine.classBegin(NUM_STATION_CLASSES); }
+    int words() const { return (size() + 63) / 64; }
+    
+    bool isBusy(int i) const { return (busy[i >> 6] >> (i & 63)) & 1; }
+    bool operandsReady(int i) const { return qj[i] == NO_TAG && qk[i] == NO_TAG; }
+    
+    StationClass classOf(int i) const {
+        int c = 0;
+        while (i >= classBegin(c + 1)) c++;
+        return static_cast<StationClass>(c);
+    }
+    
+    string name(int i) const {
+        StationClass c = classOf(i);
+        return STATION_PREFIXES[c] + to_string(i - classBegin(c) + 1);
+    }
+    
+    // Primeira estacao livre da classe; -1 se todas ocupadas. Com StaticMachine
+    // os limites sao constantes e o laco cobre as palavras certas sem calculo.
+    int findFree(StationClass c) const {
+        int begin = classBegin(c);
+        int end = classBegin(c + 1);
+        for (int w = begin >> 6; w << 6 < end; w++) {
+            uint64_t free_bits = ~busy[w];
+            int low = max(begin - (w << 6), 0);
+            int high = min(end - (w << 6), 64);
+            if (low > 0) free_bits &= ~0ULL << low;
+            if (high < 64) free_bits &= (1ULL << high) - 1;
+            if (free_bits) return (w << 6) + lowestBit(free_bits);
+        }
+        return -1;
+    }
     
-    ReservationStation() : busy(false), instr_id(-1), dest_reg(-1), cycles_left(0), address(0) {}
+    void acquire(int i) { busy[i >> 6] |= 1ULL << (i & 63); }
+    
+    void release(int i) {
+        busy[i >> 6] &= ~(1ULL << (i & 63));
+        instr_id[i] = -1;
+        qj[i] = NO_TAG;
+        qk[i] = NO_TAG;
+        vj[i] = 0;
+        vk[i] = 0;
+        address[i] = 0;
+        dest[i] = NO_TAG;
+    }
+    
+    // Entregar o resultado da tag as estacoes da mascara consumers (as que
+    // esperam a tag em qj ou qk), zerando-a, e acrescentar em woken as que
+    // ficaram com os dois operandos, em ordem de emissao
+    void broadcast(int tag, float value, uint64_t* consumers, vector<int>& woken) {
+        size_t first = woken.size();
+        int station_words = words();
+        for (int w = 0; w < station_words; w++) {
+            if (!consumers[w]) continue;
+            for (uint64_t pending = consumers[w]; pending; pending &= pending - 1) {
+                int i = (w << 6) + lowestBit(pending);
+                if (qj[i] == tag) {
+                    vj[i] = value;
+                    qj[i] = NO_TAG;
+                }
+                if (qk[i] == tag) {
+                    vk[i] = value;
+                    qk[i] = NO_TAG;
+                }
+                if (operandsReady(i)) woken.push_back(i);
+            }
+            consumers[w] = 0;
+        }
+        if (woken.size() - first > 1) {
+            sort(woken.begin() + first, woken.end(),
+                 [this](int a, int b) { return instr_id[a] < instr_id[b]; });
+        }
+    }
 };
 
 // Registrador com renomeacao
 struct Register {
-    float value;
-    string producer_tag; // Tag da estação que vai produzir o valor
-    bool ready;
-    bool busy; // Indica se o registrador está ocupado
+    float value;      // Valor arquitetural (atualizado no commit)
+    int producer_tag; // Tag do ROB da escrita mais recente em voo (NO_TAG se nenhuma)
     
-    Register() : value(0.0), producer_tag(""), ready(true), busy(false) {}
+    Register() : value(0.0), producer_tag(NO_TAG) {}
+    
+    bool ready() const { return producer_tag == NO_TAG; }
 };
 
 // Instrucao em execucao
 struct ExecutingInstruction {
-    int station_idx;
-    string station_type;
-    int remaining_cycles;
-    int instruction_id;
-    
-    ExecutingInstruction(int idx, string type, int cycles, int id)
-        : station_idx(idx), station_type(type), remaining_cycles(cycles), instruction_id(id) {}
-};
-
-// Estrutura do ROB
-struct ReorderBufferEntry {
-    bool busy;
-    int instruction_index;
-    OpType type;
-    string state;  // EMPTY, ISSUE, EXECUTE, WRITE_RESULT
-    string destination_register;
+    int station;              // Indice na StationTable
+    int unit;                 // Unidade funcional ocupada
+    long long done_cycle;     // Ciclo em que a execucao termina
+    long long unit_free;      // Ciclo em que a unidade volta a aceitar operacoes
+    long long instruction_id;
+    long long seq;            // Ordem de inicio (desempate entre conclusoes no mesmo ciclo)
+    
+    ExecutingInstruction(int st, int u, long long done, long long free, long long id, long long s)
+        : station(st), unit(u), done_cycle(done), unit_free(free), instruction_id(id), seq(s) {}
+    
+    // Ordenacao de min-heap: menor done_cycle (e menor seq) no topo
+    bool operator>(const ExecutingInstruction& other) const {
+        if (done_cycle != other.done_cycle) return done_cycle > other.done_cycle;
+        return seq > other.seq;
+    }
+};
+
+// Estado de uma entrada do ROB
+enum RobState { ROB_EMPTY, ROB_ISSUE, ROB_WRITE_RESULT };
+const char* const ROB_STATE_NAMES[] = {"EMPTY", "ISSUE", "WRITE_RESULT"};
+
+// Reorder buffer no formato SoA, indexado pela tag. A leitura de operandos na
+// emissao so toca value_ready/value, e o commit so a entrada da cabeca.
+template <class Machine>
+struct ReorderBuffer {
+    static const size_t CAPACITY = Machine::MAX_ROB;
+    static const size_t CONSUMER_WORDS = (Machine::MAX_STATIONS + 63) / 64;
+    
+    typename Machine::template Array<uint8_t, CAPACITY> busy;
+    typename Machine::template Array<long long, CAPACITY> instruction_index;
+    typename Machine::template Array<OpType, CAPACITY> type;
+    typename Machine::template Array<RobState, CAPACITY> state;
+    typename Machine::template Array<int, CAPACITY> destination_register; // Registrador renomeado pela entrada (indice reverso tag -> registrador)
+    typename Machine::template Array<float, CAPACITY> value;
+    typename Machine::template Array<Address, CAPACITY> address;
+    typename Machine::template Array<uint8_t, CAPACITY> value_ready;
+    // LOAD/STORE: endereco ja calculado (base disponivel); LOAD: valor ja obtido
+    // e id do STORE que o encaminhou (-1 = lido da memoria)
+    typename Machine::template Array<uint8_t, CAPACITY> address_ready;
+    typename Machine::template Array<uint8_t, CAPACITY> loaded;
+    typename Machine::template Array<long long, CAPACITY> load_source;
+    typename Machine::template Array<uint8_t, CAPACITY> div_by_zero; // Contada no commit
+    // Por tag, mascara das estacoes que esperam o resultado
+    typename Machine::template Array<uint64_t, CAPACITY * CONSUMER_WORDS> consumers;
+    int consumer_words; // Palavras da mascara (StationTable::words())
+    
+    ReorderBuffer() : consumer_words(0) {}
+    
+    void init(int size, int station_words) {
+        resetArray(busy, size, uint8_t(0));
+        resetArray(instruction_index, size, -1LL);
+        resetArray(type, size, ADD);
+        resetArray(state, size, ROB_EMPTY);
+        resetArray(destination_register, size, NO_REG);
+        resetArray(value, size, 0.0f);
+        resetArray(address, size, Address(0));
+        resetArray(value_ready, size, uint8_t(0));
+        resetArray(address_ready, size, uint8_t(0));
+        resetArray(loaded, size, uint8_t(0));
+        resetArray(load_source, size, -1LL);
+        resetArray(div_by_zero, size, uint8_t(0));
+        consumer_words = station_words;
+        resetArray(consumers, static_cast<size_t>(size) * station_words, uint64_t(0));
+    }
+    
+    uint64_t* consumersOf(int tag) { return &consumers[static_cast<size_t>(tag) * consumer_words]; }
+    
+    void addConsumer(int tag, int station) {
+        consumersOf(tag)[station >> 6] |= 1ULL << (station & 63);
+    }
+};
+
+// Resultado aguardando o Common Data Bus
+struct CDBEntry {
+    long long instr_id;
     float value;
-    int address;
-    bool value_ready;
+    int rob_tag;
     
-    ReorderBufferEntry() : busy(false), instruction_index(-1), type(ADD), 
-                          state("EMPTY"), value(0), address(0), value_ready(false) {}
+    CDBEntry() : instr_id(-1), value(0), rob_tag(NO_TAG) {}
+    CDBEntry(long long id, float v, int tag) : instr_id(id), value(v), rob_tag(tag) {}
 };
 
-class TomasuloSimulator {
+// Fila FIFO circular de capacidade fixa: depois de reserve() nenhuma operacao
+// aloca memoria, ao contrario de deque (blocos novos) ou vector::erase (copias)
+template <class T>
+class RingBuffer {
 private:
-    // Estações de reserva
-    vector<ReservationStation> add_stations;
-    vector<ReservationStation> mult_stations;
-    vector<ReservationStation> load_stations;
-    vector<ReservationStation> store_stations;
+    vector<T> slots;
+    size_t head;
+    size_t count;
     
-    // Banco de registradores
-    map<string, Register> registers;
+public:
+    RingBuffer() : head(0), count(0) {}
+    
+    void reserve(size_t capacity) {
+        slots.assign(capacity, T());
+        head = 0;
+        count = 0;
+    }
     
-    // Fila de instrucoes
-    queue<Instruction> instruction_queue;
-    vector<Instruction> all_instructions;
+    size_t size() const { return count; }
+    size_t capacity() const { return slots.size(); }
+    bool empty() const { return count == 0; }
+    bool full() const { return count == slots.size(); }
     
-    // Controle de ciclos
-    int current_cycle;
+    // Elemento i a partir da frente (0 = mais antigo)
+    T& operator[](size_t i) { return slots[(head + i) % slots.size()]; }
+    const T& operator[](size_t i) const { return slots[(head + i) % slots.size()]; }
+    T& front() { return slots[head]; }
+    const T& front() const { return slots[head]; }
+    T& back() { return (*this)[count - 1]; }
     
-    // Latências das operacoes
-    map<OpType, int> latencies;
+    void push_back(const T& value) {
+        slots[(head + count) % slots.size()] = value;
+        count++;
+    }
     
-    // Memória simulada
-    vector<float> memory;
+    // Devolver um elemento a frente da fila (reexecucao apos descarte)
+    void push_front(const T& value) {
+        head = (head + slots.size() - 1) % slots.size();
+        slots[head] = value;
+        count++;
+    }
     
-    // Instrucoes em execucao
-    vector<ExecutingInstruction> executing_instructions;
+    void pop_front() {
+        head = (head + 1) % slots.size();
+        count--;
+    }
     
-    // Reorder Buffer (ROB)
-    vector<ReorderBufferEntry> rob;
-    int rob_size;
-    int rob_head;
-    int rob_tail;
-    int rob_entries_available;
+    void pop_back() { count--; }
     
-    // Fila de instruções completadas aguardando CDB
-    vector<tuple<int, float, string>> completed_for_cdb;
+    void clear() {
+        head = 0;
+        count = 0;
+    }
+    
+    // Remover o elemento i mantendo a ordem dos demais
+    void erase(size_t i) {
+        for (; i > 0; i--) (*this)[i] = (*this)[i - 1];
+        pop_front();
+    }
+};
 
+// Memoria de palavras (float) esparsa, com espaco de enderecos de 32 ou 64
+// bits. Uma pagina so e alocada quando escrita; ler uma pagina nunca escrita
+// devolve 0. Enderecos fora de [0, size()) sao falhas: a leitura da 0 e a
+// escrita e ignorada. Paginas escritas pelo programa ficam marcadas como
+// modificadas, para que dumps visitem so elas. O indice de paginas e
+// reservado em init(), entao criar uma pagina no laco de ciclos aloca so a
+// propria pagina (contada a parte em pageAllocations()).
+class SparseMemory {
 public:
-    TomasuloSimulator() : current_cycle(1) {
-        // Inicializar estações de reserva
-        add_stations.resize(3);
-        mult_stations.resize(2);
-        load_stations.resize(2);
-        store_stations.resize(2);
-        
-        // Definir latências
-        latencies[ADD] = 2;
-        latencies[SUB] = 2;
-        latencies[MUL] = 10;
-        latencies[DIV] = 40;
-        latencies[LOAD] = 3;
-        latencies[STORE] = 3;
-        
-        // Inicializar ROB
-        rob_size = 16;
-        rob.resize(rob_size);
-        rob_head = 0;
-        rob_tail = 0;
-        rob_entries_available = rob_size;
-        
-        // Inicializar registradores com valores aleatórios
-        srand(time(0));
-        for (int i = 0; i < 32; i++) {
-            float random_value = (rand() % 10) * 10.0;
-            registers["R" + to_string(i)] = Register();
-            registers["F" + to_string(i)] = Register();
-            registers["R" + to_string(i)].value = random_value;
-            registers["F" + to_string(i)].value = random_value;
+    static const int PAGE_BITS = 10;
+    static const uint64_t PAGE_WORDS = 1ULL << PAGE_BITS;
+    static const uint64_t RESERVED_PAGES = 64; // Paginas indexadas sem realocar
+    
+private:
+    struct Page {
+        uint64_t number;
+        bool dirty;
+        float words[PAGE_WORDS];
+    };
+    
+    uint64_t limit;                       // Palavras enderecaveis
+    vector<unique_ptr<Page>> pages;       // Em ordem de alocacao
+    vector<Page*> table;                  // Numero da pagina -> pagina (hash aberto, potencia de 2)
+    Page* last;                           // Ultima pagina acessada (evita o hash em acessos vizinhos)
+    long long page_allocations;           // Alocacoes feitas ao criar paginas
+    
+    size_t slot(uint64_t number) const {
+        size_t mask = table.size() - 1;
+        size_t i = static_cast<size_t>((number * 0x9E3779B97F4A7C15ULL) >> 32) & mask;
+        while (table[i] && table[i]->number != number) i = (i + 1) & mask;
+        return i;
+    }
+    
+    Page* find(uint64_t number) {
+        if (last && last->number == number) return last;
+        Page* page = table[slot(number)];
+        if (page) last = page;
+        return page;
+    }
+    
+    // Tabela com pelo menos o dobro de entradas que paginas
+    void resizeTable(size_t pages_count) {
+        size_t size = 2;
+        while (size < 2 * pages_count) size *= 2;
+        table.assign(size, nullptr);
+        for (const auto& page : pages) table[slot(page->number)] = page.get();
+    }
+    
+    Page* touch(uint64_t number) {
+        Page* page = find(number);
+        if (!page) {
+            long long before = allocation_count;
+            if (2 * (pages.size() + 1) > table.size()) resizeTable(pages.size() + 1);
+            pages.emplace_back(new Page());
+            page = pages.back().get();
+            page->number = number;
+            page->dirty = false;
+            fill(page->words, page->words + PAGE_WORDS, 0.0f);
+            table[slot(number)] = page;
+            last = page;
+            page_allocations += allocation_count - before;
         }
-        
-        // Inicializar memória
-        memory.resize(1024, 0.0);
+        return page;
     }
     
-    // Carregar instrucoes do arquivo
-    bool loadInstructions(const string& filename) {
+    // Paginas em ordem de endereco
+    vector<const Page*> sortedPages() const {
+        vector<const Page*> sorted;
+        for (const auto& page : pages) sorted.push_back(page.get());
+        sort(sorted.begin(), sorted.end(),
+             [](const Page* a, const Page* b) { return a->number < b->number; });
+        return sorted;
+    }
+    
+public:
+    SparseMemory() : limit(0), last(nullptr), page_allocations(0) {}
+    
+    void init(uint64_t words) {
+        limit = words;
+        pages.clear();
+        last = nullptr;
+        uint64_t reserved = (words + PAGE_WORDS - 1) >> PAGE_BITS;
+        if (reserved > RESERVED_PAGES) reserved = RESERVED_PAGES;
+        pages.reserve(reserved);
+        resizeTable(reserved);
+    }
+    
+    uint64_t size() const { return limit; }
+    size_t pageCount() const { return pages.size(); }
+    
+    // Alocacoes feitas pela thread corrente ao criar paginas (a primeira
+    // escrita numa pagina aloca mesmo depois do aquecimento)
+    long long pageAllocations() const { return page_allocations; }
+    
+    size_t dirtyPageCount() const {
+        size_t count = 0;
+        for (const auto& page : pages) count += page->dirty;
+        return count;
+    }
+    
+    bool contains(Address address) const {
+        return address >= 0 && static_cast<uint64_t>(address) < limit;
+    }
+    
+    float read(Address address) {
+        if (!contains(address)) return 0;
+        Page* page = find(static_cast<uint64_t>(address) >> PAGE_BITS);
+        return page ? page->words[address & (PAGE_WORDS - 1)] : 0;
+    }
+    
+    void write(Address address, float value) {
+        if (!contains(address)) return;
+        Page* page = touch(static_cast<uint64_t>(address) >> PAGE_BITS);
+        page->words[address & (PAGE_WORDS - 1)] = value;
+        page->dirty = true;
+    }
+    
+    // Carregar "endereco valor" por linha (# inicia comentario). Os valores
+    // iniciais nao marcam as paginas como modificadas.
+    bool load(const string& filename, string& error) {
         ifstream file(filename);
         if (!file.is_open()) {
-            cout << "Erro: Nao foi possível abrir o arquivo " << filename << endl;
+            error = "nao foi possivel abrir " + filename;
             return false;
         }
-        
         string line;
-        int instr_id = 1;
-        
+        long long line_number = 0;
         while (getline(file, line)) {
-            if (line.empty() || line[0] == '#') continue;
-            
-            istringstream iss(line);
-            string op_str, dest, src1, src2;
-            
-            iss >> op_str >> dest >> src1 >> src2;
-            
-            OpType op;
-            if (op_str == "ADD") op = ADD;
-            else if (op_str == "SUB") op = SUB;
-            else if (op_str == "MUL") op = MUL;
-            else if (op_str == "DIV") op = DIV;
-            else if (op_str == "LOAD") op = LOAD;
-            else if (op_str == "STORE") op = STORE;
-            else continue;
-            
-            // Remover vírgulas
-            dest.erase(remove(dest.begin(), dest.end(), ','), dest.end());
-            src1.erase(remove(src1.begin(), src1.end(), ','), src1.end());
-            src2.erase(remove(src2.begin(), src2.end(), ','), src2.end());
-            
-            Instruction instr(instr_id++, op, dest, src1, src2);
-            instruction_queue.push(instr);
-            all_instructions.push_back(instr);
+            line_number++;
+            size_t comment = line.find('#');
+            if (comment != string::npos) line.erase(comment);
+            istringstream fields(line);
+            long long address = 0;
+            float value = 0;
+            string extra;
+            if (!(fields >> address)) {
+                if (line.find_first_not_of(" \t\r") == string::npos) continue;
+                error = filename + ":" + to_string(line_number) + ": esperado endereco valor";
+                return false;
+            }
+            if (!(fields >> value) || (fields >> extra)) {
+                error = filename + ":" + to_string(line_number) + ": esperado endereco valor";
+                return false;
+            }
+            if (!contains(address)) {
+                error = filename + ":" + to_string(line_number) + ": endereco " + to_string(address)
+                        + " fora da memoria (" + to_string(limit) + " palavras)";
+                return false;
+            }
+            touch(static_cast<uint64_t>(address) >> PAGE_BITS)->words[address & (PAGE_WORDS - 1)] = value;
         }
-        
-        file.close();
         return true;
     }
     
-    // Verificar se há estação de reserva disponível
-    int findFreeStation(OpType op) {
-        vector<ReservationStation>* stations;
-        
-        switch (op) {
-            case ADD:
-            case SUB:
-                stations = &add_stations;
-                break;
-            case MUL:
-            case DIV:
-                stations = &mult_stations;
-                break;
-            case LOAD:
-                stations = &load_stations;
-                break;
-            case STORE:
-                stations = &store_stations;
-                break;
-        }
-        
-        for (int i = 0; i < stations->size(); i++) {
-            if (!(*stations)[i].busy) {
-                return i;
+    // Visitar em ordem de endereco as palavras nao nulas das paginas alocadas
+    // (ou so das modificadas)
+    template <class Visitor>
+    void forEachWord(bool dirty_only, Visitor visit) const {
+        for (const Page* page : sortedPages()) {
+            if (dirty_only && !page->dirty) continue;
+            for (uint64_t i = 0; i < PAGE_WORDS; i++) {
+                if (page->words[i] != 0.0f) visit(static_cast<Address>((page->number << PAGE_BITS) | i), page->words[i]);
             }
         }
-        return -1;
     }
     
-    // Verificar hazards
-    bool checkHazards(const Instruction& instr) {
-        // Check for RAW hazards
-        if (!registers[instr.src1].ready || !registers[instr.src2].ready) {
-            return true;
-        }
-        
-        // Check for WAW hazards
-        if (instr.op != STORE && registers[instr.dest].busy) {
-            return true;
+    // Gravar/restaurar as paginas num checkpoint (CheckpointWriter/Reader)
+    template <class Writer>
+    void save(Writer& writer) const {
+        writer.put(limit);
+        writer.put(static_cast<uint64_t>(pages.size()));
+        for (const auto& page : pages) {
+            writer.put(page->number);
+            writer.put(page->dirty);
+            writer.put(page->words);
         }
-        
-        return false;
     }
     
-    // Emitir instrucao
-    bool issueInstruction() {
-        if (instruction_queue.empty() || rob_entries_available == 0) return false;
-        
-        Instruction& instr = instruction_queue.front();
-        
-        // Verificar hazards antes de emitir
-        if (checkHazards(instr)) return false;
-        
-        int station_idx = findFreeStation(instr.op);
-        if (station_idx == -1) return false; // Hazard estrutural
-        
-        // Alocar entrada no ROB
-        int current_rob_idx = rob_tail;
-        ReorderBufferEntry& rob_entry = rob[current_rob_idx];
-        rob_entry.busy = true;
-        rob_entry.instruction_index = instr.id;
-        rob_entry.type = instr.op;
-        rob_entry.state = "ISSUE";
-        
-        // Configurar destino e endereço no ROB
-        if (instr.op != STORE) {
-            rob_entry.destination_register = instr.dest;
-        }
-        
-        if (instr.op == LOAD || instr.op == STORE) {
-            // Extrair offset e registrador base do formato offset(Rbase)
-            size_t open_paren = instr.src1.find('(');
-            size_t close_paren = instr.src1.find(')');
-            
-            if (open_paren != string::npos && close_paren != string::npos) {
-                int offset = stoi(instr.src1.substr(0, open_paren));
-                string base_reg = instr.src1.substr(open_paren + 1, close_paren - open_paren - 1);
-                rob_entry.address = offset + static_cast<int>(registers[base_reg].value);
-            }
-        }
-        
-        // Atualizar ponteiros do ROB
-        rob_tail = (rob_tail + 1) % rob_size;
-        rob_entries_available--;
-        
-        // Selecionar estação de reserva apropriada
-        ReservationStation* station;
-        string station_name;
-        
-        switch (instr.op) {
-            case ADD:
-            case SUB:
-                station = &add_stations[station_idx];
-                station_name = "Add" + to_string(station_idx + 1);
-                break;
-            case MUL:
-            case DIV:
-                station = &mult_stations[station_idx];
-                station_name = "Mult" + to_string(station_idx + 1);
-                break;
-            case LOAD:
-                station = &load_stations[station_idx];
-                station_name = "Load" + to_string(station_idx + 1);
-                break;
-            case STORE:
-                station = &store_stations[station_idx];
-                station_name = "Store" + to_string(station_idx + 1);
-                break;
+    template <class Reader>
+    bool restore(Reader& reader) {
+        uint64_t words = 0;
+        uint64_t count = 0;
+        reader.get(words);
+        reader.get(count);
+        if (!reader.ok() || words != limit) return false;
+        init(limit);
+        for (uint64_t i = 0; i < count && reader.ok(); i++) {
+            uint64_t number = 0;
+            reader.get(number);
+            if (number > (limit - 1) >> PAGE_BITS) return false;
+            Page* page = touch(number);
+            reader.get(page->dirty);
+            reader.get(page->words);
         }
-        
-        // Configurar estação de reserva
-        station->busy = true;
-        station->op = instr.op;
-        station->instr_id = instr.id;
-        station->cycles_left = latencies[instr.op];
-        station->dest = to_string(current_rob_idx);  // Tag do ROB como destino
-        
-        // Configurar endereço para LOAD/STORE
-        if (instr.op == LOAD || instr.op == STORE) {
-            station->address = rob_entry.address;
+        return reader.ok();
+    }
+};
+
+// Formatacao de tags do ROB para impressao
+string tagToString(int tag) {
+    return tag == NO_TAG ? "-" : to_string(tag);
+}
+
+// Formatacao de operando: valor se disponivel, "-" se aguardando produtor
+string operandToString(bool busy, int tag, float value) {
+    if (!busy || tag != NO_TAG) return "-";
+    ostringstream oss;
+    oss << fixed << setprecision(2) << value;
+    return oss.str();
+}
+
+const char* opName(OpType op) {
+    switch (op) {
+        case ADD: return "ADD";
+        case SUB: return "SUB";
+        case MUL: return "MUL";
+        case DIV: return "DIV";
+        case LOAD: return "LOAD";
+        case STORE: return "STORE";
+        case BRANCH: return "BRANCH";
+    }
+    return "?";
+}
+
+// Mnemonico da instrucao (o do desvio depende da condicao)
+const char* instructionName(const Instruction& instr) {
+    return instr.op == BRANCH ? BRANCH_NAMES[instr.cond] : opName(instr.op);
+}
+
+// Texto da instrucao ("ADD F1, F2, F3", "LOAD F1, 4(R2)", "BEQ R1, R2, 7",
+// com o pc do alvo) sem alocar: Sink tem put(char), putText e putInt
+template <class Sink>
+void writeInstructionText(Sink& out, const Instruction& instr) {
+    auto reg = [&out](int id) {
+        out.put(id < REGS_PER_BANK ? 'R' : 'F');
+        out.putInt(id % REGS_PER_BANK);
+    };
+    out.putText(instructionName(instr));
+    if (instr.op == LOAD || instr.op == STORE) {
+        out.put(' ');
+        reg(instr.dest);
+        out.putText(", ");
+        out.putInt(instr.offset);
+        out.put('(');
+        if (instr.base_reg != NO_REG) reg(instr.base_reg);
+        out.put(')');
+        return;
+    }
+    const int operands[] = {instr.dest, instr.src1, instr.src2};
+    bool first = true;
+    for (int id : operands) {
+        if (id == NO_REG) continue;
+        out.putText(first ? " " : ", ");
+        reg(id);
+        first = false;
+    }
+    if (instr.op == BRANCH) {
+        out.putText(", ");
+        out.putInt(instr.target);
+    }
+}
+
+// Sink de writeInstructionText para relatorios (aloca)
+struct StringSink {
+    string text;
+    
+    void put(char c) { text += c; }
+    void putText(const char* part) { text += part; }
+    void putInt(long long value) { text += to_string(value); }
+};
+
+// Resultado da comparacao de um desvio
+bool branchTaken(BranchCondition cond, float a, float b) {
+    switch (cond) {
+        case BRANCH_EQ: return a == b;
+        case BRANCH_NE: return a != b;
+        case BRANCH_LT: return a < b;
+        case BRANCH_GE: return a >= b;
+    }
+    return false;
+}
+
+// Resultado de uma operacao, comum a execucao detalhada e ao interpretador
+// funcional. LOAD le a memoria; STORE devolve o dado (vk), que quem chama grava
+// na memoria no commit. div_by_zero indica DIV com divisor zero (resultado 0).
+float executeOperation(OpType op, float vj, float vk, Address address, SparseMemory& memory,
+                       bool& div_by_zero) {
+    switch (op) {
+        case ADD: return vj + vk;
+        case SUB: return vj - vk;
+        case MUL: return vj * vk;
+        case DIV:
+            if (vk != 0) return vj / vk;
+            div_by_zero = true;
+            return 0;
+        case LOAD:
+            return memory.read(address);
+        case STORE:
+            return vk;
+        case BRANCH: // Resolvido com branchTaken(), que depende da condicao
+            return 0;
+    }
+    return 0;
+}
+
+// Proximo token separado por espacos a partir de pos; false no fim da linha
+bool nextToken(const string& line, size_t& pos, const char*& begin, const char*& end) {
+    while (pos < line.size() && isspace(static_cast<unsigned char>(line[pos]))) pos++;
+    if (pos >= line.size()) return false;
+    begin = line.data() + pos;
+    while (pos < line.size() && !isspace(static_cast<unsigned char>(line[pos]))) pos++;
+    end = line.data() + pos;
+    return true;
+}
+
+bool tokenEquals(const char* begin, const char* end, const char* word) {
+    size_t length = strlen(word);
+    return static_cast<size_t>(end - begin) == length && memcmp(begin, word, length) == 0;
+}
+
+// Rotulos de uma linha, como trechos [begin, end) dela: o definido no inicio
+// ("laco:" sozinho ou antes da instrucao) e o alvo de um desvio. Os rotulos
+// sao resolvidos para pcs por quem le o programa inteiro (fonte texto e
+// --convert), pois um desvio pode referir um rotulo adiante.
+struct LineLabels {
+    const char* defined_begin;
+    const char* defined_end;
+    const char* target_begin;
+    const char* target_end;
+    
+    LineLabels() : defined_begin(nullptr), defined_end(nullptr), target_begin(nullptr), target_end(nullptr) {}
+    
+    string defined() const { return string(defined_begin, defined_end); }
+    string target() const { return string(target_begin, target_end); }
+};
+
+// Interpretar uma linha do arquivo de instrucoes; false para comentarios,
+// linhas vazias, linhas so com rotulo e operacoes desconhecidas. O id e o pc
+// ficam a cargo de quem chama, e o alvo do desvio (target) fica -1: o rotulo
+// vai em labels, se pedido. Trabalha direto sobre a linha, sem criar
+// strings: e chamada a cada instrucao buscada durante a simulacao.
+bool parseInstructionLine(const string& line, Instruction& instr, LineLabels* labels = nullptr) {
+    if (line.empty() || line[0] == '#') return false;
+    
+    // Rotulo opcional, operacao e ate tres operandos (vazios se ausentes)
+    const char* tokens[4][2] = {};
+    size_t pos = 0;
+    if (!nextToken(line, pos, tokens[0][0], tokens[0][1])) return false;
+    if (tokens[0][1][-1] == ':') {
+        if (labels) {
+            labels->defined_begin = tokens[0][0];
+            labels->defined_end = tokens[0][1] - 1;
         }
-        
-        // Verificar dependências e renomear registradores
-        if (instr.op != STORE) {
-            // Para instruções que escrevem em registrador
-            registers[instr.dest].producer_tag = to_string(current_rob_idx);  // Tag do ROB
-            registers[instr.dest].ready = false;
-            registers[instr.dest].busy = true;
+        if (!nextToken(line, pos, tokens[0][0], tokens[0][1])) return false;
+    }
+    for (int t = 1; t < 4 && nextToken(line, pos, tokens[t][0], tokens[t][1]); t++) {}
+    
+    static const OpType ops[] = {ADD, SUB, MUL, DIV, LOAD, STORE};
+    const int num_ops = sizeof(ops) / sizeof(ops[0]);
+    int op_index = 0;
+    while (op_index < num_ops && !tokenEquals(tokens[0][0], tokens[0][1], opName(ops[op_index]))) {
+        op_index++;
+    }
+    if (op_index == num_ops) {
+        // Desvio: "BEQ R1, R2, rotulo"
+        int cond = 0;
+        while (cond < NUM_BRANCH_CONDITIONS && !tokenEquals(tokens[0][0], tokens[0][1], BRANCH_NAMES[cond])) {
+            cond++;
         }
-        
-        // Configurar operandos usando tags do ROB
-        if (registers[instr.src1].ready) {
-            station->vj = to_string(registers[instr.src1].value);
-            station->qj = "";
-        } else {
-            station->vj = "";
-            station->qj = registers[instr.src1].producer_tag;  // Tag do ROB
+        if (cond == NUM_BRANCH_CONDITIONS) return false;
+        instr = Instruction(0, BRANCH, NO_REG, parseRegister(tokens[1][0], tokens[1][1]),
+                            parseRegister(tokens[2][0], tokens[2][1]));
+        instr.cond = static_cast<BranchCondition>(cond);
+        if (labels && tokens[3][0]) {
+            labels->target_begin = tokens[3][0];
+            labels->target_end = tokens[3][1];
+            while (labels->target_end > labels->target_begin && labels->target_end[-1] == ',') labels->target_end--;
         }
+        return true;
+    }
+    OpType op = ops[op_index];
+    
+    // Resolver nomes de registradores uma unica vez (virgulas sao ignoradas)
+    instr = Instruction(0, op, parseRegister(tokens[1][0], tokens[1][1]),
+                        parseRegister(tokens[2][0], tokens[2][1]),
+                        parseRegister(tokens[3][0], tokens[3][1]));
+    
+    if ((op == LOAD || op == STORE) && tokens[2][0]) {
+        // Extrair offset e registrador base do formato offset(Rbase)
+        const char* begin = tokens[2][0];
+        const char* end = tokens[2][1];
+        const char* open_paren = find(begin, end, '(');
+        const char* close_paren = find(begin, end, ')');
         
-        if (!instr.src2.empty() && instr.op != LOAD && instr.op != STORE) {
-            if (registers[instr.src2].ready) {
-                station->vk = to_string(registers[instr.src2].value);
-                station->qk = "";
-            } else {
-                station->vk = "";
-                station->qk = registers[instr.src2].producer_tag;  // Tag do ROB
+        if (open_paren < close_paren && close_paren != end) {
+            int64_t sign = 1;
+            int64_t offset = 0;
+            const char* c = begin;
+            while (c < open_paren && *c == ',') c++;
+            bool has_sign = c < open_paren && (*c == '-' || *c == '+');
+            if (has_sign) sign = (*c++ == '-') ? -1 : 1;
+            const char* digits = c;
+            // Acima de 2^31 o valor ja nao cabe em int32_t: parar de acumular
+            const int64_t limit = static_cast<int64_t>(numeric_limits<int32_t>::max()) + 1;
+            for (; c < open_paren && (isdigit(static_cast<unsigned char>(*c)) || *c == ','); c++) {
+                if (*c != ',' && offset <= limit) offset = offset * 10 + (*c - '0');
+            }
+            offset *= sign;
+            // Offset nao numerico ("abc(R1)"), so sinal ou fora de int32_t:
+            // base fica NO_REG e o endereco e rejeitado como invalido
+            bool numeric = c == open_paren && (!has_sign || c > digits) &&
+                           offset >= numeric_limits<int32_t>::min() && offset <= numeric_limits<int32_t>::max();
+            if (numeric) {
+                instr.offset = static_cast<int>(offset);
+                instr.base_reg = parseRegister(open_paren + 1, close_paren);
             }
         }
-        
-        // Adicionar à lista de instruções em execução
-        executing_instructions.push_back(ExecutingInstruction(
-            station_idx,
-            station_name,
-            latencies[instr.op],
-            instr.id
-        ));
-        
-        instr.issue_cycle = current_cycle;
-        instruction_queue.pop();
-        
-        return true;
     }
+    return true;
+}
+
+// Fonte de instrucoes lida sob demanda, sem carregar o programa inteiro. A
+// leitura segue um pc: next() entrega a instrucao do pc corrente e avanca, e
+// jump() continua em outro pc (alvo de desvio ou recuperacao de previsao errada).
+class InstructionSource {
+public:
+    virtual ~InstructionSource() {}
+    
+    // Instrucao no pc corrente (com pc e, nos desvios, target preenchidos); false no fim
+    virtual bool next(Instruction& instr) = 0;
+    
+    // Continuar a leitura em pc: um rotulo ou a instrucao seguinte a um desvio
+    virtual bool jump(long long pc) = 0;
+    virtual long long pc() const = 0;
+    
+    // Posicao de leitura para checkpoint (opaca, -1 = fim) e retomada a partir
+    // dela, com o pc correspondente
+    virtual long long cursor() = 0;
+    virtual bool seek(long long position, long long pc) = 0;
+};
+
+// Fonte no formato texto (instructions*.txt). Ao abrir, o arquivo e percorrido
+// uma vez para resolver os rotulos; ficam em memoria so os alvos dos desvios e
+// os offsets das linhas para onde a leitura pode saltar (rotulos e instrucoes
+// seguintes a desvios), que crescem com o numero de desvios, nao de instrucoes.
+class TextInstructionSource : public InstructionSource {
+private:
+    ifstream file;
+    string line;
+    long long next_pc;
+    unordered_map<long long, long long> branch_targets; // pc do desvio -> pc do alvo
+    unordered_map<long long, long long> jump_offsets;   // pc -> offset da linha
+    
+public:
+    TextInstructionSource() : next_pc(0) {}
     
-    // Executar instrucoes
-    void executeInstructions() {
-        // Verificar todas as estações de reserva
-        vector<vector<ReservationStation>*> all_stations = {
-            &add_stations, &mult_stations, &load_stations, &store_stations
+    // Abrir e resolver os rotulos; error descreve a falha (com a linha)
+    bool open(const string& filename, string& error) {
+        file.open(filename);
+        if (!file.is_open()) {
+            error = "nao foi possivel abrir o arquivo";
+            return false;
+        }
+        struct PendingBranch {
+            long long pc;
+            long long line_number;
+            string label;
         };
-        
-        // Processar instrucoes em execucao
-        for (auto it = executing_instructions.begin(); it != executing_instructions.end();) {
-            it->remaining_cycles--;
-            
-            if (it->remaining_cycles <= 0) {
-                // Instrucao terminou execucao - calcular resultado real
-                float result = 0.0;
-                ReservationStation* station = nullptr;
-                
-                // Encontrar a estação correspondente
-                if (it->station_type.find("Add") != string::npos) {
-                    station = &add_stations[it->station_idx];
-                } else if (it->station_type.find("Mult") != string::npos) {
-                    station = &mult_stations[it->station_idx];
-                } else if (it->station_type.find("Load") != string::npos) {
-                    station = &load_stations[it->station_idx];
-                } else if (it->station_type.find("Store") != string::npos) {
-                    station = &store_stations[it->station_idx];
-                }
-                
-                if (station != nullptr) {
-                    switch (station->op) {
-                        case ADD:
-                            result = stof(station->vj) + stof(station->vk);
-                            break;
-                        case SUB:
-                            result = stof(station->vj) - stof(station->vk);
-                            break;
-                        case MUL:
-                            result = stof(station->vj) * stof(station->vk);
-                            break;
-                        case DIV:
-                            if (stof(station->vk) != 0) {
-                                result = stof(station->vj) / stof(station->vk);
-                            } else {
-                                cerr << "Erro: Divisao por zero!" << endl;
-                                result = 0;
-                            }
-                            break;
-                        case LOAD:
-                            result = memory[station->address];
-                            break;
-                        case STORE:
-                            memory[station->address] = stof(station->vj);
-                            break;
-                    }
-                    
-                    // Adicionar ao CDB
-                    completed_for_cdb.push_back({station->instr_id, result, station->dest});
-                    
-                    // Liberar a estação
-                    station->busy = false;
+        unordered_map<string, long long> labels;
+        vector<PendingBranch> pending;
+        long long pc = 0;
+        long long offset = 0;
+        long long line_number = 0;
+        Instruction instr;
+        while (getline(file, line)) {
+            line_number++;
+            long long line_offset = offset;
+            offset += static_cast<long long>(line.size()) + 1;
+            LineLabels found;
+            bool is_instruction = parseInstructionLine(line, instr, &found);
+            if (found.defined_begin) {
+                if (!labels.emplace(found.defined(), pc).second) {
+                    error = "linha " + to_string(line_number) + ": rotulo " + found.defined() + " repetido";
+                    return false;
                 }
-                
-                // Remover da lista de instruções em execução
-                it = executing_instructions.erase(it);
-            } else {
-                ++it;
+                jump_offsets.emplace(pc, line_offset);
+            }
+            if (!is_instruction) continue;
+            if ((instr.op == LOAD || instr.op == STORE) && instr.base_reg == NO_REG && instr.src1 == NO_REG) {
+                error = "linha " + to_string(line_number) + ": endereco invalido (esperado offset(Rbase))";
+                return false;
+            }
+            if (instr.op == BRANCH) {
+                pending.push_back({pc, line_number, found.target_begin ? found.target() : string()});
+                jump_offsets.emplace(pc + 1, offset);
             }
+            pc++;
         }
+        for (const PendingBranch& branch : pending) {
+            auto it = labels.find(branch.label);
+            if (it == labels.end()) {
+                error = "linha " + to_string(branch.line_number) + ": rotulo "
+                        + (branch.label.empty() ? "alvo ausente" : branch.label + " nao definido");
+                return false;
+            }
+            branch_targets[branch.pc] = it->second;
+        }
+        file.clear();
+        file.seekg(0);
+        return true;
+    }
+    
+    bool next(Instruction& instr) override {
+        while (getline(file, line)) {
+            if (parseInstructionLine(line, instr)) {
+                instr.pc = next_pc++;
+                if (instr.op == BRANCH) instr.target = branchTarget(instr.pc);
+                return true;
+            }
+        }
+        return false;
+    }
+    
+    bool jump(long long pc) override {
+        if (pc == next_pc) return true;
+        auto it = jump_offsets.find(pc);
+        if (it == jump_offsets.end()) return false;
+        return seek(it->second, pc);
+    }
+    
+    long long pc() const override { return next_pc; }
+    
+    // Alvo resolvido do desvio em pc (-1 se nao ha desvio nele)
+    long long branchTarget(long long pc) const {
+        auto it = branch_targets.find(pc);
+        return it == branch_targets.end() ? -1 : it->second;
+    }
+    
+    // Offset em bytes da proxima linha
+    long long cursor() override {
+        if (!file.good()) return -1;
+        return static_cast<long long>(file.tellg());
+    }
+    
+    bool seek(long long position, long long pc) override {
+        next_pc = pc;
+        file.clear();
+        if (position < 0) {
+            file.seekg(0, ios::end);
+        } else {
+            file.seekg(position);
+        }
+        return static_cast<bool>(file);
+    }
+};
+
+// Formato binario de trace: cabecalho seguido de registros de tamanho fixo,
+// little-endian, lidos diretamente do arquivo mapeado em memoria. A versao 2
+// acrescenta os desvios; traces da versao 1 continuam validos.
+const char TRACE_MAGIC[4] = {'T', 'M', 'S', 'L'};
+const uint16_t TRACE_VERSION = 2;
+
+struct TraceHeader {
+    char magic[4];        // "TMSL"
+    uint16_t version;     // TRACE_VERSION
+    uint16_t record_size; // sizeof(TraceRecord)
+    uint64_t count;       // Numero de instrucoes
+};
+
+struct TraceRecord {
+    uint8_t op;           // OpType
+    int8_t dest;          // Ids de registradores (-1 = NO_REG)
+    int8_t src1;
+    int8_t src2;
+    int8_t base_reg;      // Base do endereco de LOAD/STORE
+    uint8_t cond;         // BranchCondition do desvio
+    uint8_t reserved[2];
+    int32_t offset;       // Offset do endereco de LOAD/STORE; pc do alvo do desvio
+};
+
+static_assert(sizeof(TraceHeader) == 16, "TraceHeader deve ter 16 bytes");
+static_assert(sizeof(TraceRecord) == 12, "TraceRecord deve ter 12 bytes");
+
+// Converter entre a ordem do arquivo (little-endian) e a do host; a mesma
+// funcao serve para ler e gravar. Nao faz nada em hosts little-endian.
+template <class T>
+T littleEndian(T value) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    unsigned char bytes[sizeof(T)];
+    memcpy(bytes, &value, sizeof(T));
+    reverse(bytes, bytes + sizeof(T));
+    memcpy(&value, bytes, sizeof(T));
+#endif
+    return value;
+}
+
+TraceRecord encodeTraceRecord(const Instruction& instr) {
+    TraceRecord record;
+    memset(&record, 0, sizeof(record));
+    record.op = static_cast<uint8_t>(instr.op);
+    record.dest = static_cast<int8_t>(instr.dest);
+    record.src1 = static_cast<int8_t>(instr.src1);
+    record.src2 = static_cast<int8_t>(instr.src2);
+    record.base_reg = static_cast<int8_t>(instr.base_reg);
+    record.offset = littleEndian<int32_t>(instr.offset);
+    if (instr.op == BRANCH) {
+        record.cond = static_cast<uint8_t>(instr.cond);
+        record.offset = littleEndian(static_cast<int32_t>(instr.target));
+    }
+    return record;
+}
+
+// Validar e decodificar um registro; false se o registro estiver corrompido
+bool decodeTraceRecord(const TraceRecord& record, Instruction& instr) {
+    if (record.op > BRANCH) return false;
+    const int8_t regs[] = {record.dest, record.src1, record.src2, record.base_reg};
+    for (int8_t reg : regs) {
+        if (reg < NO_REG || reg >= NUM_REGS) return false;
+    }
+    int32_t offset = littleEndian(record.offset);
+    instr = Instruction(0, static_cast<OpType>(record.op), record.dest, record.src1, record.src2,
+                        offset, record.base_reg);
+    if (instr.op == BRANCH) {
+        if (record.cond >= NUM_BRANCH_CONDITIONS || offset < 0) return false;
+        instr.cond = static_cast<BranchCondition>(record.cond);
+        instr.target = offset;
+        instr.offset = 0;
+    }
+    return true;
+}
+
+// Tamanho do arquivo em bytes; -1 se nao puder ser aberto
+long long fileSize(const string& filename) {
+    ifstream file(filename, ios::binary | ios::ate);
+    return file.is_open() ? static_cast<long long>(file.tellg()) : -1;
+}
+
+bool isBinaryTrace(const string& filename) {
+    ifstream file(filename, ios::binary);
+    char magic[4];
+    return file.read(magic, sizeof(magic)) && memcmp(magic, TRACE_MAGIC, sizeof(magic)) == 0;
+}
+
+// Fonte no formato binario: os registros sao lidos no proprio mapeamento do
+// arquivo, sem copia nem parsing
+class BinaryInstructionSource : public InstructionSource {
+private:
+    const TraceRecord* records;
+    uint64_t count;
+    uint64_t position;
+#ifdef _WIN32
+    vector<char> data; // Sem mmap: arquivo lido inteiro
+#else
+    void* mapping;
+    size_t mapping_size;
+#endif
+    
+public:
+#ifdef _WIN32
+    BinaryInstructionSource() : records(nullptr), count(0), position(0) {}
+#else
+    BinaryInstructionSource() : records(nullptr), count(0), position(0), mapping(nullptr), mapping_size(0) {}
+    
+    ~BinaryInstructionSource() {
+        if (mapping) munmap(mapping, mapping_size);
+    }
+#endif
+    
+    // Mapear o arquivo e validar o cabecalho; error descreve a falha
+    bool open(const string& filename, string& error) {
+        const char* base = nullptr;
+        size_t size = 0;
+#ifdef _WIN32
+        ifstream file(filename, ios::binary);
+        if (!file.is_open()) {
+            error = "nao foi possivel abrir o arquivo";
+            return false;
+        }
+        data.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+        base = data.data();
+        size = data.size();
+#else
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0) {
+            error = "nao foi possivel abrir o arquivo";
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(TraceHeader))) {
+            ::close(fd);
+            error = "arquivo menor que o cabecalho";
+            return false;
+        }
+        mapping_size = static_cast<size_t>(st.st_size);
+        mapping = mmap(nullptr, mapping_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (mapping == MAP_FAILED) {
+            mapping = nullptr;
+            error = "falha no mmap";
+            return false;
+        }
+        madvise(mapping, mapping_size, MADV_SEQUENTIAL);
+        base = static_cast<const char*>(mapping);
+        size = mapping_size;
+#endif
+        if (size < sizeof(TraceHeader)) {
+            error = "arquivo menor que o cabecalho";
+            return false;
+        }
+        TraceHeader header;
+        memcpy(&header, base, sizeof(header));
+        header.version = littleEndian(header.version);
+        header.record_size = littleEndian(header.record_size);
+        header.count = littleEndian(header.count);
+        if (memcmp(header.magic, TRACE_MAGIC, sizeof(header.magic)) != 0) {
+            error = "assinatura invalida";
+            return false;
+        }
+        if (header.version < 1 || header.version > TRACE_VERSION) {
+            error = "versao " + to_string(header.version) + " nao suportada (esperada ate "
+                    + to_string(TRACE_VERSION) + ")";
+            return false;
+        }
+        if (header.record_size != sizeof(TraceRecord) ||
+            (size - sizeof(TraceHeader)) / sizeof(TraceRecord) < header.count) {
+            error = "tamanho de registro ou numero de instrucoes inconsistente";
+            return false;
+        }
+        records = reinterpret_cast<const TraceRecord*>(base + sizeof(TraceHeader));
+        count = header.count;
+        // Validar todos os registros agora: um registro corrompido no meio do
+        // trace falha a carga em vez de encerrar o programa ali
+        Instruction instr;
+        for (uint64_t i = 0; i < count; i++) {
+            if (!decodeTraceRecord(records[i], instr) ||
+                (instr.op == BRANCH && static_cast<uint64_t>(instr.target) > count)) {
+                error = "registro " + to_string(i) + " invalido";
+                return false;
+            }
+        }
+        return true;
+    }
+    
+    // Registros ja validados em open()
+    bool next(Instruction& instr) override {
+        if (position >= count) return false;
+        decodeTraceRecord(records[position], instr);
+        instr.pc = static_cast<long long>(position++);
+        return true;
+    }
+    
+    bool jump(long long pc) override { return seek(pc, pc); }
+    long long pc() const override { return static_cast<long long>(position); }
+    
+    // Indice do proximo registro (igual ao pc)
+    long long cursor() override { return static_cast<long long>(position); }
+    
+    bool seek(long long record, long long) override {
+        if (record < 0 || static_cast<uint64_t>(record) > count) return false;
+        position = static_cast<uint64_t>(record);
+        return true;
+    }
+};
+
+// Compilar um arquivo de instrucoes texto para o formato binario, validando
+// cada linha. Retorna o numero de erros encontrados (0 = sucesso).
+int convertTextTrace(const string& input, const string& output, ostream& log) {
+    ifstream in(input);
+    if (!in.is_open()) {
+        log << "Erro: Nao foi possivel abrir o arquivo " << input << "\n";
+        return 1;
+    }
+    // Rotulos resolvidos pela fonte texto (alvos gravados como pcs)
+    TextInstructionSource labels;
+    string label_error;
+    if (!labels.open(input, label_error)) {
+        log << input << ": " << label_error << "\n";
+        return 1;
+    }
+    ofstream out(output, ios::binary);
+    if (!out.is_open()) {
+        log << "Erro: Nao foi possivel criar o arquivo " << output << "\n";
+        return 1;
+    }
+    
+    TraceHeader header;
+    memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+    header.version = littleEndian(TRACE_VERSION);
+    header.record_size = littleEndian<uint16_t>(sizeof(TraceRecord));
+    header.count = 0;
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    uint64_t count = 0;
+    
+    string line;
+    long long line_number = 0;
+    int errors = 0;
+    while (getline(in, line)) {
+        line_number++;
+        if (line.find_first_not_of(" \t\r") == string::npos || line[0] == '#') continue;
+        
+        Instruction instr;
+        LineLabels found;
+        string error;
+        if (!parseInstructionLine(line, instr, &found)) {
+            if (found.defined_begin) continue; // Linha so com rotulo
+            error = "operacao desconhecida";
+        } else if (instr.op == BRANCH) {
+            instr.target = labels.branchTarget(static_cast<long long>(count));
+            if (instr.src1 == NO_REG || instr.src2 == NO_REG) error = "registrador fonte invalido";
+        } else if (instr.dest == NO_REG) {
+            error = "registrador destino invalido";
+        } else if (instr.op == LOAD || instr.op == STORE) {
+            if (instr.base_reg == NO_REG && instr.src1 == NO_REG) {
+                error = "endereco invalido (esperado offset(Rbase))";
+            }
+        } else if (instr.src1 == NO_REG || instr.src2 == NO_REG) {
+            error = "registrador fonte invalido";
+        }
+        
+        if (!error.empty()) {
+            log << input << ":" << line_number << ": " << error << ": " << line << "\n";
+            errors++;
+            continue;
+        }
+        
+        TraceRecord record = encodeTraceRecord(instr);
+        out.write(reinterpret_cast<const char*>(&record), sizeof(record));
+        count++;
+    }
+    
+    header.count = littleEndian(count);
+    out.seekp(0);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.close();
+    if (!out) {
+        log << "Erro: falha ao gravar " << output << "\n";
+        return errors + 1;
+    }
+    if (errors > 0) {
+        // Nao deixar um trace parcial que pareca valido
+        remove(output.c_str());
+        log << errors << " linhas com erro; " << output << " nao foi gerado\n";
+        return errors;
+    }
+    log << count << " instrucoes gravadas em " << output << "\n";
+    return 0;
+}
+
+// Saida de texto gravada por uma thread de fundo, para registros emitidos a
+// cada instrucao ou ciclo (--pipeview, --deltas). Dois buffers de tamanho fixo: a
+// simulacao preenche um enquanto a thread grava o outro no arquivo, e so
+// espera se a thread ainda nao terminou o anterior. Depois de open() nao ha
+// alocacao; os numeros sao formatados direto no buffer.
+class BufferedWriter {
+private:
+    static const size_t BUFFER_SIZE = 1 << 20;
+    
+    ofstream file;
+    vector<char> filling;  // Preenchido pela simulacao
+    vector<char> flushing; // Gravado pela thread
+    size_t used;
+    size_t pending;        // Bytes de flushing a gravar (0 = thread livre)
+    bool closing;
+    mutex lock;
+    condition_variable wake;  // Para a thread: buffer a gravar ou fim
+    condition_variable ready; // Para a simulacao: thread livre
+    thread worker;
+    
+    void run() {
+        unique_lock<mutex> guard(lock);
+        while (true) {
+            wake.wait(guard, [this] { return pending > 0 || closing; });
+            if (pending == 0) break;
+            size_t size = pending;
+            guard.unlock();
+            file.write(flushing.data(), size);
+            guard.lock();
+            pending = 0;
+            ready.notify_one();
+        }
+    }
+    
+    // Entregar o buffer cheio a thread e continuar no outro
+    void flushBuffer() {
+        unique_lock<mutex> guard(lock);
+        ready.wait(guard, [this] { return pending == 0; });
+        filling.swap(flushing);
+        pending = used;
+        used = 0;
+        wake.notify_one();
+    }
+    
+public:
+    BufferedWriter() : used(0), pending(0), closing(false) {}
+    ~BufferedWriter() { close(); }
+    
+    bool open(const string& filename) {
+        file.open(filename, ios::binary);
+        if (!file.is_open()) return false;
+        filling.resize(BUFFER_SIZE);
+        flushing.resize(BUFFER_SIZE);
+        worker = thread(&BufferedWriter::run, this);
+        return true;
+    }
+    
+    void write(const char* data, size_t size) {
+        while (size > 0) {
+            if (used == BUFFER_SIZE) flushBuffer();
+            size_t chunk = min(size, BUFFER_SIZE - used);
+            memcpy(filling.data() + used, data, chunk);
+            used += chunk;
+            data += chunk;
+            size -= chunk;
+        }
+    }
+    
+    void put(char c) {
+        if (used == BUFFER_SIZE) flushBuffer();
+        filling[used++] = c;
+    }
+    
+    void putText(const char* text) { write(text, strlen(text)); }
+    
+    void putInt(long long value) {
+        char digits[24];
+        int n = 0;
+        unsigned long long magnitude = value < 0 ? 0ULL - static_cast<unsigned long long>(value) : value;
+        do {
+            digits[n++] = static_cast<char>('0' + magnitude % 10);
+            magnitude /= 10;
+        } while (magnitude > 0);
+        if (value < 0) put('-');
+        while (n > 0) put(digits[--n]);
+    }
+    
+    // Numero em JSON: %.9g preserva o float; nan/inf viram null
+    void putFloat(double value) {
+        if (!isfinite(value)) {
+            putText("null");
+            return;
+        }
+        char digits[32];
+        int n = snprintf(digits, sizeof(digits), "%.9g", value);
+        write(digits, static_cast<size_t>(n));
+    }
+    
+    // Hexadecimal com ao menos width digitos
+    void putHex(uint64_t value, int width) {
+        char digits[16];
+        int n = 0;
+        do {
+            digits[n++] = "0123456789abcdef"[value & 15];
+            value >>= 4;
+        } while (value > 0);
+        for (int pad = n; pad < width; pad++) put('0');
+        while (n > 0) put(digits[--n]);
+    }
+    
+    // Gravar o restante e encerrar a thread; false se a gravacao falhou
+    bool close() {
+        if (!worker.joinable()) return !file.fail();
+        if (used > 0) flushBuffer();
+        {
+            lock_guard<mutex> guard(lock);
+            closing = true;
+        }
+        wake.notify_one();
+        worker.join();
+        file.close();
+        return !file.fail();
+    }
+};
+
+// Ticks por ciclo no --pipeview (o o3-pipeview.py usa --cycle-time 1000)
+const long long PIPEVIEW_TICKS_PER_CYCLE = 1000;
+
+// Formato binario de checkpoint: cabecalho seguido do estado completo do
+// simulador, campo a campo, na ordem de TomasuloSimulator::saveCheckpoint()
+const char CHECKPOINT_MAGIC[4] = {'T', 'M', 'C', 'K'};
+const uint16_t CHECKPOINT_VERSION = 10;
+
+class CheckpointWriter {
+private:
+    ofstream file;
+    
+public:
+    bool open(const string& filename) {
+        file.open(filename, ios::binary);
+        if (!file.is_open()) return false;
+        file.write(CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+        put(CHECKPOINT_VERSION);
+        return true;
+    }
+    
+    // Valor trivialmente copiavel, gravado byte a byte
+    template <class T>
+    void put(const T& value) {
+        file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+    
+    void putString(const string& text) {
+        put(static_cast<uint64_t>(text.size()));
+        file.write(text.data(), text.size());
+    }
+    
+    // vector ou std::array: tamanho seguido dos elementos
+    template <class Array>
+    void putArray(const Array& values) {
+        put(static_cast<uint64_t>(values.size()));
+        file.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(values[0]));
+    }
+    
+    bool close() {
+        file.close();
+        return !file.fail();
+    }
+};
+
+// Leitura na mesma ordem da gravacao. Os vetores de estado ja estao
+// dimensionados pela configuracao, entao um tamanho diferente indica um
+// checkpoint de outra maquina (ou corrompido) e invalida a leitura.
+class CheckpointReader {
+private:
+    ifstream file;
+    bool valid;
+    
+public:
+    CheckpointReader() : valid(false) {}
+    
+    bool open(const string& filename, string& error) {
+        file.open(filename, ios::binary);
+        if (!file.is_open()) {
+            error = "nao foi possivel abrir o arquivo";
+            return false;
+        }
+        char magic[4];
+        uint16_t version = 0;
+        valid = true;
+        file.read(magic, sizeof(magic));
+        get(version);
+        if (!ok() || memcmp(magic, CHECKPOINT_MAGIC, sizeof(magic)) != 0) {
+            error = "assinatura invalida";
+            return false;
+        }
+        if (version != CHECKPOINT_VERSION) {
+            error = "versao " + to_string(version) + " nao suportada (esperada "
+                    + to_string(CHECKPOINT_VERSION) + ")";
+            return false;
+        }
+        return true;
+    }
+    
+    bool ok() const { return valid && !file.fail(); }
+    
+    template <class T>
+    void get(T& value) {
+        file.read(reinterpret_cast<char*>(&value), sizeof(T));
+    }
+    
+    void getString(string& text) {
+        uint64_t size = 0;
+        get(size);
+        if (!ok() || size > (1u << 20)) {
+            valid = false;
+            return;
+        }
+        text.resize(size);
+        file.read(&text[0], size);
+    }
+    
+    template <class Array>
+    void getArray(Array& values) {
+        uint64_t size = 0;
+        get(size);
+        if (!ok() || size != values.size()) {
+            valid = false;
+            return;
+        }
+        file.read(reinterpret_cast<char*>(values.data()), values.size() * sizeof(values[0]));
+    }
+};
+
+// Politica de arbitragem dos CDBs quando ha mais resultados que barramentos
+enum CdbArbitration { CDB_FIFO, CDB_OLDEST };
+const char* const CDB_ARBITRATION_NAMES[] = {"fifo", "oldest"};
+
+// Politica de substituicao das caches
+enum CacheReplacement { REPLACE_LRU, REPLACE_PLRU };
+const char* const CACHE_REPLACEMENT_NAMES[] = {"lru", "plru"};
+
+// Preditor de direcao dos desvios: estatico (para tras tomado, para frente
+// nao tomado), contadores de 2 bits por pc (bimodal) ou por pc XOR historico
+// global (gshare)
+enum PredictorKind { PREDICT_STATIC, PREDICT_BIMODAL, PREDICT_GSHARE };
+const char* const PREDICTOR_NAMES[] = {"static", "bimodal", "gshare"};
+
+// Configuracao da maquina simulada, lida de arquivo "chave = valor" e/ou
+// sobrescrita por --set na linha de comando
+struct MachineConfig {
+    int add_stations;
+    int mult_stations;
+    int load_stations;
+    int store_stations;
+    int latencies[NUM_OPS]; // Indexado por OpType
+    int rob_size;
+    int memory_size;        // Numero de palavras da memoria (se address_bits = 0)
+    int address_bits;       // Espaco de 2^address_bits palavras (32 ou 64, p.ex.); 0 = memory_size
+    int cdb_count;          // Resultados transmitidos por ciclo
+    int cdb_arbitration;    // CdbArbitration
+    int issue_width;        // Instrucoes emitidas por ciclo
+    int commit_width;       // Instrucoes commitadas por ciclo
+    // Caches de dados (tamanhos em palavras; l1_size = 0 desliga as caches e
+    // LOAD/STORE usam latency_load/latency_store)
+    int l1_size;
+    int l1_assoc;
+    int l1_latency;         // Acerto na L1
+    int l2_size;            // 0 = sem L2
+    int l2_assoc;
+    int l2_latency;         // Acerto na L2 (somado a l1_latency)
+    int memory_latency;     // Falta na ultima cache (somado as latencias das caches)
+    int line_size;          // Palavras por linha (L1 e L2)
+    int cache_replacement;  // CacheReplacement
+    int mshr_count;         // Faltas da L1 em andamento ao mesmo tempo
+    // Previsao de desvios
+    int branch_predictor;   // PredictorKind
+    int predictor_bits;     // 2^predictor_bits contadores de 2 bits
+    int history_bits;       // Bits do historico global (gshare)
+    int btb_size;           // Entradas do BTB (mapeamento direto); 0 = alvo sempre conhecido
+    // Unidades funcionais por tipo (FuKind). fu_count = 0 da uma unidade por
+    // estacao que executa o tipo, como se cada estacao tivesse a sua. Uma
+    // unidade pipelined aceita outra operacao intervals[op] ciclos depois de
+    // iniciar uma; as demais ficam ocupadas pela latencia inteira.
+    int fu_count[NUM_FU_KINDS];
+    int fu_pipelined[NUM_FU_KINDS];
+    int intervals[NUM_OPS]; // Intervalo de iniciacao, indexado por OpType
+    
+    MachineConfig() : add_stations(3), mult_stations(2), load_stations(2), store_stations(2),
+                      rob_size(16), memory_size(1024), address_bits(0), cdb_count(1),
+                      cdb_arbitration(CDB_OLDEST),
+                      issue_width(1), commit_width(1), l1_size(0), l1_assoc(4), l1_latency(2),
+                      l2_size(0), l2_assoc(8), l2_latency(10), memory_latency(100), line_size(16),
+                      cache_replacement(REPLACE_LRU), mshr_count(4), branch_predictor(PREDICT_BIMODAL),
+                      predictor_bits(10), history_bits(8), btb_size(64) {
+        latencies[ADD] = 2;
+        latencies[SUB] = 2;
+        latencies[MUL] = 10;
+        latencies[DIV] = 40;
+        latencies[LOAD] = 3;
+        latencies[STORE] = 3;
+        latencies[BRANCH] = 1;
+        for (int kind = 0; kind < NUM_FU_KINDS; kind++) {
+            fu_count[kind] = 0;
+            fu_pipelined[kind] = kind != FU_DIV;
+        }
+        for (int op = 0; op < NUM_OPS; op++) intervals[op] = 1;
+    }
+    
+    // Alguma chave fu_*, pipelined_* ou interval_* difere do padrao
+    bool customUnits() const {
+        MachineConfig defaults;
+        for (int kind = 0; kind < NUM_FU_KINDS; kind++) {
+            if (fu_count[kind] != defaults.fu_count[kind] || fu_pipelined[kind] != defaults.fu_pipelined[kind]) {
+                return true;
+            }
+        }
+        for (int op = 0; op < NUM_OPS; op++) {
+            if (intervals[op] != defaults.intervals[op]) return true;
+        }
+        return false;
+    }
+    
+    static const vector<string>& keys() {
+        static const vector<string> names = {
+            "add_stations", "mult_stations", "load_stations", "store_stations",
+            "latency_add", "latency_sub", "latency_mul", "latency_div",
+            "latency_load", "latency_store", "latency_branch", "rob_size", "memory_size", "address_bits",
+            "cdb_count", "cdb_arbitration", "issue_width", "commit_width", "l1_size", "l1_assoc",
+            "l1_latency", "l2_size", "l2_assoc", "l2_latency", "memory_latency", "line_size",
+            "cache_replacement", "mshr_count", "branch_predictor", "predictor_bits", "history_bits",
+            "btb_size", "fu_alu", "fu_mul", "fu_div", "fu_mem", "pipelined_alu", "pipelined_mul",
+            "pipelined_div", "pipelined_mem", "interval_add", "interval_sub", "interval_mul",
+            "interval_div", "interval_load", "interval_store", "interval_branch"
+        };
+        return names;
+    }
+    
+    // Campo associado a uma chave; nullptr se a chave nao existir
+    int* field(const string& key) {
+        if (key == "add_stations") return &add_stations;
+        if (key == "mult_stations") return &mult_stations;
+        if (key == "load_stations") return &load_stations;
+        if (key == "store_stations") return &store_stations;
+        if (key == "latency_add") return &latencies[ADD];
+        if (key == "latency_sub") return &latencies[SUB];
+        if (key == "latency_mul") return &latencies[MUL];
+        if (key == "latency_div") return &latencies[DIV];
+        if (key == "latency_load") return &latencies[LOAD];
+        if (key == "latency_store") return &latencies[STORE];
+        if (key == "latency_branch") return &latencies[BRANCH];
+        if (key == "rob_size") return &rob_size;
+        if (key == "memory_size") return &memory_size;
+        if (key == "address_bits") return &address_bits;
+        if (key == "cdb_count") return &cdb_count;
+        if (key == "cdb_arbitration") return &cdb_arbitration;
+        if (key == "issue_width") return &issue_width;
+        if (key == "commit_width") return &commit_width;
+        if (key == "l1_size") return &l1_size;
+        if (key == "l1_assoc") return &l1_assoc;
+        if (key == "l1_latency") return &l1_latency;
+        if (key == "l2_size") return &l2_size;
+        if (key == "l2_assoc") return &l2_assoc;
+        if (key == "l2_latency") return &l2_latency;
+        if (key == "memory_latency") return &memory_latency;
+        if (key == "line_size") return &line_size;
+        if (key == "cache_replacement") return &cache_replacement;
+        if (key == "mshr_count") return &mshr_count;
+        if (key == "branch_predictor") return &branch_predictor;
+        if (key == "predictor_bits") return &predictor_bits;
+        if (key == "history_bits") return &history_bits;
+        if (key == "btb_size") return &btb_size;
+        if (key == "fu_alu") return &fu_count[FU_ALU];
+        if (key == "fu_mul") return &fu_count[FU_MUL];
+        if (key == "fu_div") return &fu_count[FU_DIV];
+        if (key == "fu_mem") return &fu_count[FU_MEM];
+        if (key == "pipelined_alu") return &fu_pipelined[FU_ALU];
+        if (key == "pipelined_mul") return &fu_pipelined[FU_MUL];
+        if (key == "pipelined_div") return &fu_pipelined[FU_DIV];
+        if (key == "pipelined_mem") return &fu_pipelined[FU_MEM];
+        if (key == "interval_add") return &intervals[ADD];
+        if (key == "interval_sub") return &intervals[SUB];
+        if (key == "interval_mul") return &intervals[MUL];
+        if (key == "interval_div") return &intervals[DIV];
+        if (key == "interval_load") return &intervals[LOAD];
+        if (key == "interval_store") return &intervals[STORE];
+        if (key == "interval_branch") return &intervals[BRANCH];
+        return nullptr;
+    }
+    
+    const int* field(const string& key) const {
+        return const_cast<MachineConfig*>(this)->field(key);
+    }
+    
+    bool set(const string& key, const string& value, string& error) {
+        int* target = field(key);
+        if (!target) {
+            error = "chave desconhecida '" + key + "'";
+            return false;
+        }
+        if (key == "cdb_arbitration") {
+            for (int policy = CDB_FIFO; policy <= CDB_OLDEST; policy++) {
+                if (value == CDB_ARBITRATION_NAMES[policy]) {
+                    *target = policy;
+                    return true;
+                }
+            }
+            error = "valor invalido '" + value + "' para " + key + " (use fifo ou oldest)";
+            return false;
+        }
+        if (key == "cache_replacement") {
+            for (int policy = REPLACE_LRU; policy <= REPLACE_PLRU; policy++) {
+                if (value == CACHE_REPLACEMENT_NAMES[policy]) {
+                    *target = policy;
+                    return true;
+                }
+            }
+            error = "valor invalido '" + value + "' para " + key + " (use lru ou plru)";
+            return false;
+        }
+        if (key == "branch_predictor") {
+            for (int kind = PREDICT_STATIC; kind <= PREDICT_GSHARE; kind++) {
+                if (value == PREDICTOR_NAMES[kind]) {
+                    *target = kind;
+                    return true;
+                }
+            }
+            error = "valor invalido '" + value + "' para " + key + " (use static, bimodal ou gshare)";
+            return false;
+        }
+        char* end = nullptr;
+        long parsed = strtol(value.c_str(), &end, 10);
+        if (value.empty() || *end != '\0' || parsed < 0 || parsed > 1000000000L) {
+            error = "valor invalido '" + value + "' para " + key;
+            return false;
+        }
+        *target = static_cast<int>(parsed);
+        return true;
+    }
+    
+    // Aplicar "chave=valor" (formato de --set)
+    bool setAssignment(const string& assignment, string& error) {
+        size_t eq = assignment.find('=');
+        if (eq == string::npos) {
+            error = "esperado chave=valor em '" + assignment + "'";
+            return false;
+        }
+        return set(trim(assignment.substr(0, eq)), trim(assignment.substr(eq + 1)), error);
+    }
+    
+    bool loadFile(const string& filename, string& error) {
+        ifstream file(filename);
+        if (!file.is_open()) {
+            error = "nao foi possivel abrir " + filename;
+            return false;
+        }
+        return load(file, filename, error);
+    }
+    
+    // Linhas "chave = valor" (comentarios com #); name identifica a origem nos erros
+    bool load(istream& file, const string& name, string& error) {
+        string line;
+        int line_number = 0;
+        while (getline(file, line)) {
+            line_number++;
+            size_t comment = line.find('#');
+            if (comment != string::npos) line.erase(comment);
+            if (trim(line).empty()) continue;
+            if (!setAssignment(line, error)) {
+                error = name + ":" + to_string(line_number) + ": " + error;
+                return false;
+            }
+        }
+        return true;
+    }
+    
+    bool validate(string& error) const {
+        for (const string& key : keys()) {
+            if (key == "cdb_arbitration" || key == "cache_replacement" || key == "address_bits" ||
+                key == "l1_size" || key == "l2_size" || key == "branch_predictor" || key == "btb_size") {
+                continue;
+            }
+            if (key.compare(0, 3, "fu_") == 0 || key.compare(0, 10, "pipelined_") == 0) {
+                if (*field(key) < 0 || (key[0] == 'p' && *field(key) > 1)) {
+                    error = key + (key[0] == 'p' ? " deve ser 0 ou 1" : " deve ser >= 0");
+                    return false;
+                }
+                continue;
+            }
+            if (*field(key) < 1) {
+                error = key + " deve ser >= 1";
+                return false;
+            }
+        }
+        if (rob_size > (1 << 20)) {
+            error = "rob_size deve ser <= " + to_string(1 << 20);
+            return false;
+        }
+        if (address_bits > 64) {
+            error = "address_bits deve ser <= 64";
+            return false;
+        }
+        if (predictor_bits > 24 || history_bits > 32) {
+            error = "predictor_bits deve ser <= 24 e history_bits <= 32";
+            return false;
+        }
+        if (btb_size > 0 && !isPowerOfTwo(btb_size)) {
+            error = "btb_size deve ser 0 ou potencia de 2";
+            return false;
+        }
+        if (l2_size > 0 && l1_size == 0) {
+            error = "l2_size exige l1_size > 0";
+            return false;
+        }
+        if (l1_size > 0) {
+            if (!isPowerOfTwo(line_size)) {
+                error = "line_size deve ser potencia de 2";
+                return false;
+            }
+            if (!validCache("l1", l1_size, l1_assoc, error) ||
+                (l2_size > 0 && !validCache("l2", l2_size, l2_assoc, error))) {
+                return false;
+            }
+        }
+        return true;
+    }
+    
+    static bool isPowerOfTwo(int value) { return value > 0 && (value & (value - 1)) == 0; }
+    
+    // Numero de conjuntos potencia de 2; com PLRU, associatividade tambem
+    // potencia de 2 e no maximo 64 (bits da arvore numa palavra)
+    bool validCache(const string& level, int size, int assoc, string& error) const {
+        long long block = static_cast<long long>(assoc) * line_size;
+        if (size % block != 0 || !isPowerOfTwo(static_cast<int>(size / block))) {
+            error = level + "_size deve ser " + level + "_assoc * line_size * (potencia de 2)";
+            return false;
+        }
+        if (cache_replacement == REPLACE_PLRU && (!isPowerOfTwo(assoc) || assoc > 64)) {
+            error = level + "_assoc deve ser potencia de 2 e <= 64 com plru";
+            return false;
+        }
+        return true;
+    }
+    
+    // Palavras enderecaveis. Enderecos sao Address (com sinal), entao 64 bits
+    // cobrem os 2^63 enderecos nao negativos.
+    uint64_t memoryWords() const {
+        if (address_bits == 0) return static_cast<uint64_t>(memory_size);
+        return 1ULL << min(address_bits, 63);
+    }
+    
+    // Configuracao completa no formato de arquivo aceito por load()
+    string toString() const {
+        string text;
+        for (const string& key : keys()) text += key + " = " + valueString(key) + "\n";
+        return text;
+    }
+    
+    void print(ostream& out) const {
+        out << "Configuracao:";
+        for (const string& key : keys()) {
+            out << " " << key << "=" << valueString(key);
+        }
+        out << "\n";
+    }
+    
+    // Valor de uma chave no formato aceito por set()
+    string valueString(const string& key) const {
+        if (key == "cdb_arbitration") return CDB_ARBITRATION_NAMES[cdb_arbitration];
+        if (key == "cache_replacement") return CACHE_REPLACEMENT_NAMES[cache_replacement];
+        if (key == "branch_predictor") return PREDICTOR_NAMES[branch_predictor];
+        return to_string(*field(key));
+    }
+    
+    static string trim(const string& text) {
+        size_t begin = text.find_first_not_of(" \t\r");
+        if (begin == string::npos) return "";
+        size_t end = text.find_last_not_of(" \t\r");
+        return text.substr(begin, end - begin + 1);
+    }
+};
+
+// Contadores das caches de dados
+struct CacheStats {
+    long long l1_hits;
+    long long l1_misses;      // Faltas primarias (alocaram MSHR)
+    long long l2_hits;
+    long long l2_misses;
+    long long mshr_merges;    // Faltas secundarias: linha ja em busca por outro MSHR
+    long long mshr_stall_cycles; // Soma por ciclo das instrucoes prontas sem MSHR livre
+    
+    CacheStats() : l1_hits(0), l1_misses(0), l2_hits(0), l2_misses(0), mshr_merges(0),
+                   mshr_stall_cycles(0) {}
+    
+    long long l1Accesses() const { return l1_hits + l1_misses + mshr_merges; }
+};
+
+// Contadores da fila de loads/stores (LSQ)
+struct LsqStats {
+    long long loads;               // LOADs que obtiveram o valor (inclui reexecucoes)
+    long long forwards;            // ... encaminhado por um STORE mais antigo
+    long long speculative_loads;   // ... passando por STORE com endereco ainda desconhecido
+    long long violations;          // STOREs que resolveram o endereco de um LOAD mais novo ja lido
+    long long squashed;            // Instrucoes descartadas e emitidas de novo pelas violacoes
+    long long forward_wait_cycles; // Soma por ciclo dos LOADs esperando o dado do STORE
+    
+    LsqStats() : loads(0), forwards(0), speculative_loads(0), violations(0), squashed(0),
+                 forward_wait_cycles(0) {}
+};
+
+// Contadores dos desvios (os de previsao contam so desvios commitados)
+struct BranchStats {
+    long long branches;
+    long long taken;
+    long long mispredictions;
+    long long btb_misses;  // Previstos tomados sem alvo no BTB (a busca seguiu em frente)
+    long long recoveries;  // Recuperacoes feitas, inclusive de desvios do caminho errado
+    long long wrong_path;  // Instrucoes emitidas no caminho errado e descartadas
+    
+    BranchStats() : branches(0), taken(0), mispredictions(0), btb_misses(0), recoveries(0),
+                    wrong_path(0) {}
+};
+
+// Um nivel de cache associativo por conjunto. Guarda so as tags, em vetores
+// planos indexados por conjunto * vias + via (os dados ficam em SparseMemory).
+const uint64_t INVALID_LINE = ~0ULL; // Via vazia / MSHR sem linha
+
+struct CacheLevel {
+    int ways;
+    uint64_t set_mask;
+    CacheReplacement policy;
+    vector<uint64_t> tags;    // Numero da linha em cada via (INVALID_LINE = vazia)
+    vector<uint64_t> stamps;  // LRU: instante do ultimo uso de cada via
+    vector<uint64_t> plru;    // PLRU: bits da arvore de cada conjunto (nos 1..ways-1)
+    uint64_t clock;
+    
+    CacheLevel() : ways(0), set_mask(0), policy(REPLACE_LRU), clock(0) {}
+    
+    void init(int size, int assoc, int line_size, CacheReplacement replacement) {
+        ways = assoc;
+        uint64_t sets = static_cast<uint64_t>(size / (assoc * line_size));
+        set_mask = sets - 1;
+        policy = replacement;
+        tags.assign(sets * ways, INVALID_LINE);
+        stamps.assign(policy == REPLACE_LRU ? sets * ways : 0, 0);
+        plru.assign(policy == REPLACE_PLRU ? sets : 0, 0);
+        clock = 0;
+    }
+    
+    // Marcar a via como usada: LRU guarda o instante; PLRU aponta os nos do
+    // caminho ate a raiz para o lado oposto ao da via
+    void touch(uint64_t set, int way) {
+        if (policy == REPLACE_LRU) {
+            stamps[set * ways + way] = ++clock;
+            return;
+        }
+        uint64_t& bits = plru[set];
+        for (int node = way + ways; node > 1; node >>= 1) {
+            if (node & 1) bits &= ~(1ULL << (node >> 1));
+            else bits |= 1ULL << (node >> 1);
+        }
+    }
+    
+    int victim(uint64_t set) const {
+        const uint64_t* set_tags = &tags[set * ways];
+        for (int way = 0; way < ways; way++) {
+            if (set_tags[way] == INVALID_LINE) return way;
+        }
+        if (policy == REPLACE_LRU) {
+            const uint64_t* set_stamps = &stamps[set * ways];
+            return static_cast<int>(min_element(set_stamps, set_stamps + ways) - set_stamps);
+        }
+        int node = 1;
+        while (node < ways) node = 2 * node + ((plru[set] >> node) & 1);
+        return node - ways;
+    }
+    
+    // true se a linha esta presente (e a marca como usada)
+    bool lookup(uint64_t line) {
+        uint64_t set = line & set_mask;
+        const uint64_t* set_tags = &tags[set * ways];
+        for (int way = 0; way < ways; way++) {
+            if (set_tags[way] == line) {
+                touch(set, way);
+                return true;
+            }
+        }
+        return false;
+    }
+    
+    // Trazer a linha para o conjunto no lugar da vitima
+    void install(uint64_t line) {
+        uint64_t set = line & set_mask;
+        int way = victim(set);
+        tags[set * ways + way] = line;
+        touch(set, way);
+    }
+    
+    // Acessar a linha, trazendo-a numa falta; true em acerto
+    bool access(uint64_t line) {
+        if (lookup(line)) return true;
+        install(line);
+        return false;
+    }
+};
+
+// Hierarquia de caches de dados (L1 e L2 opcional) com MSHRs para faltas
+// nao bloqueantes. access() da a latencia de um LOAD/STORE que inicia a
+// execucao: acerto na L1, falta secundaria (junta-se ao MSHR da linha) ou
+// falta primaria (aloca um MSHR ate a linha chegar). Sem MSHR livre o acesso
+// e recusado e a instrucao tenta de novo no ciclo seguinte.
+class CacheHierarchy {
+private:
+    bool enabled;
+    bool has_l2;
+    int line_bits;
+    int l1_latency;
+    int l2_latency;
+    int memory_latency;
+    CacheLevel l1;
+    CacheLevel l2;
+    vector<uint64_t> mshr_line;   // Linha em busca em cada MSHR
+    vector<long long> mshr_ready; // Ciclo em que a linha chega (MSHR livre depois dele)
+    
+public:
+    CacheStats stats;
+    
+    CacheHierarchy() : enabled(false), has_l2(false), line_bits(0), l1_latency(0), l2_latency(0),
+                       memory_latency(0) {}
+    
+    void init(const MachineConfig& config) {
+        enabled = config.l1_size > 0;
+        if (!enabled) return;
+        has_l2 = config.l2_size > 0;
+        line_bits = 0;
+        while ((1 << line_bits) < config.line_size) line_bits++;
+        l1_latency = config.l1_latency;
+        l2_latency = config.l2_latency;
+        memory_latency = config.memory_latency;
+        CacheReplacement policy = static_cast<CacheReplacement>(config.cache_replacement);
+        l1.init(config.l1_size, config.l1_assoc, config.line_size, policy);
+        if (has_l2) l2.init(config.l2_size, config.l2_assoc, config.line_size, policy);
+        mshr_line.assign(config.mshr_count, INVALID_LINE);
+        mshr_ready.assign(config.mshr_count, -1);
+    }
+    
+    bool isEnabled() const { return enabled; }
+    int hitLatency() const { return l1_latency; }
+    
+    // Latencia do acesso iniciado em cycle; -1 se nao ha MSHR livre. Quem chama
+    // so passa enderecos da memoria (memory.contains): as falhas nao passam
+    // pelas caches e custam um acerto (hitLatency).
+    int access(Address address, long long cycle) {
+        uint64_t line = static_cast<uint64_t>(address) >> line_bits;
+        int free_mshr = -1;
+        for (size_t m = 0; m < mshr_line.size(); m++) {
+            if (mshr_ready[m] < cycle) {
+                free_mshr = static_cast<int>(m);
+            } else if (mshr_line[m] == line) {
+                stats.mshr_merges++;
+                return max(l1_latency, static_cast<int>(mshr_ready[m] - cycle + 1));
+            }
+        }
+        if (l1.lookup(line)) {
+            stats.l1_hits++;
+            return l1_latency;
+        }
+        if (free_mshr < 0) return -1;
+        
+        stats.l1_misses++;
+        l1.install(line);
+        int latency = l1_latency + memory_latency;
+        if (has_l2) {
+            latency += l2_latency;
+            if (l2.access(line)) {
+                stats.l2_hits++;
+                latency -= memory_latency;
+            } else {
+                stats.l2_misses++;
+            }
+        }
+        mshr_line[free_mshr] = line;
+        mshr_ready[free_mshr] = cycle + latency - 1;
+        return latency;
+    }
+    
+    // Aquecimento no modo funcional: atualiza tags e substituicao sem tempo,
+    // MSHRs nem contadores
+    void warm(Address address) {
+        if (!enabled || address < 0) return;
+        uint64_t line = static_cast<uint64_t>(address) >> line_bits;
+        if (!l1.access(line) && has_l2) l2.access(line);
+    }
+    
+    // Primeiro ciclo, a partir de cycle, com algum MSHR livre
+    long long nextMshrFree(long long cycle) const {
+        long long next = numeric_limits<long long>::max();
+        for (long long ready : mshr_ready) {
+            if (ready < cycle) return cycle;
+            next = min(next, ready + 1);
+        }
+        return next;
+    }
+    
+    // Gravar/restaurar tags, substituicao, MSHRs e contadores num checkpoint
+    template <class Writer>
+    void save(Writer& writer) const {
+        if (!enabled) return;
+        const CacheLevel* levels[] = {&l1, &l2};
+        for (const CacheLevel* level : levels) {
+            writer.putArray(level->tags);
+            writer.putArray(level->stamps);
+            writer.putArray(level->plru);
+            writer.put(level->clock);
+        }
+        writer.putArray(mshr_line);
+        writer.putArray(mshr_ready);
+        writer.put(stats);
+    }
+    
+    template <class Reader>
+    void restore(Reader& reader) {
+        if (!enabled) return;
+        CacheLevel* levels[] = {&l1, &l2};
+        for (CacheLevel* level : levels) {
+            reader.getArray(level->tags);
+            reader.getArray(level->stamps);
+            reader.getArray(level->plru);
+            reader.get(level->clock);
+        }
+        reader.getArray(mshr_line);
+        reader.getArray(mshr_ready);
+        reader.get(stats);
+    }
+};
+
+// Preditor de desvios consultado na busca. A direcao vem de uma tabela de
+// contadores de 2 bits indexada pelo pc (bimodal) ou pelo pc XOR o historico
+// global (gshare), ou da regra estatica "para tras tomado". O historico e
+// atualizado especulativamente na busca e restaurado na recuperacao; os
+// contadores e o BTB so mudam no commit. Como os desvios sao diretos, o BTB
+// guarda apenas quais pcs tem alvo conhecido: previsto tomado sem entrada no
+// BTB, a busca segue em frente.
+class BranchPredictor {
+private:
+    PredictorKind kind;
+    vector<uint8_t> counters;  // 0-1 nao tomado, 2-3 tomado
+    uint64_t index_mask;
+    uint64_t history_mask;
+    uint64_t global_history;   // Especulativo: inclui desvios ainda nao commitados
+    vector<long long> btb;     // pc do desvio em cada entrada (-1 = vazia)
+    
+    size_t index(long long pc, uint64_t history) const {
+        uint64_t key = static_cast<uint64_t>(pc);
+        if (kind == PREDICT_GSHARE) key ^= history;
+        return static_cast<size_t>(key & index_mask);
+    }
+    
+public:
+    BranchPredictor() : kind(PREDICT_BIMODAL), index_mask(0), history_mask(0), global_history(0) {}
+    
+    void init(const MachineConfig& config) {
+        kind = static_cast<PredictorKind>(config.branch_predictor);
+        index_mask = (1ULL << config.predictor_bits) - 1;
+        history_mask = (1ULL << config.history_bits) - 1;
+        global_history = 0;
+        // Contadores comecam fracamente nao tomados
+        counters.assign(kind == PREDICT_STATIC ? 0 : index_mask + 1, 1);
+        btb.assign(config.btb_size, -1);
+    }
+    
+    uint64_t history() const { return global_history; }
+    
+    bool predictTaken(long long pc, long long target) const {
+        if (kind == PREDICT_STATIC) return target <= pc;
+        return counters[index(pc, global_history)] >= 2;
+    }
+    
+    bool btbHit(long long pc) const {
+        return btb.empty() || btb[static_cast<size_t>(pc) & (btb.size() - 1)] == pc;
+    }
+    
+    // Acrescentar ao historico a direcao seguida pela busca
+    void speculate(bool taken) {
+        global_history = ((global_history << 1) | (taken ? 1 : 0)) & history_mask;
+    }
+    
+    // Previsao errada: o historico volta ao da busca do desvio mais a direcao correta
+    void recover(uint64_t history_at_fetch, bool taken) {
+        global_history = history_at_fetch;
+        speculate(taken);
+    }
+    
+    // Treinar com o resultado de um desvio commitado (ou executado no modo funcional)
+    void update(long long pc, uint64_t history_at_fetch, bool taken) {
+        if (kind != PREDICT_STATIC) {
+            uint8_t& counter = counters[index(pc, history_at_fetch)];
+            if (taken && counter < 3) counter++;
+            if (!taken && counter > 0) counter--;
+        }
+        if (taken && !btb.empty()) btb[static_cast<size_t>(pc) & (btb.size() - 1)] = pc;
+    }
+    
+    template <class Writer>
+    void save(Writer& writer) const {
+        writer.putArray(counters);
+        writer.put(global_history);
+        writer.putArray(btb);
+    }
+    
+    template <class Reader>
+    void restore(Reader& reader) {
+        reader.getArray(counters);
+        reader.get(global_history);
+        reader.getArray(btb);
+    }
+};
+
+// Contadores das unidades funcionais, por tipo
+struct FuStats {
+    vector<long long> busy_cycles[NUM_FU_KINDS]; // Por unidade: ciclos sem aceitar outra operacao
+    long long operations[NUM_FU_KINDS];
+    long long wait_cycles[NUM_FU_KINDS];         // Soma por ciclo das instrucoes prontas sem unidade livre
+    
+    FuStats() {
+        for (int kind = 0; kind < NUM_FU_KINDS; kind++) {
+            operations[kind] = 0;
+            wait_cycles[kind] = 0;
+        }
+    }
+    
+    long long waitCycles() const {
+        long long total = 0;
+        for (int kind = 0; kind < NUM_FU_KINDS; kind++) total += wait_cycles[kind];
+        return total;
+    }
+};
+
+// Unidades funcionais agrupadas por tipo. Uma instrucao com operandos prontos
+// so inicia a execucao se alguma unidade do tipo estiver livre; a unidade fica
+// reservada pelo intervalo de iniciacao da operacao (pipelined) ou pela
+// latencia inteira. Cada unidade guarda apenas o ciclo em que volta a aceitar
+// operacoes.
+class FunctionalUnits {
+private:
+    int first[NUM_FU_KINDS + 1]; // Unidades do tipo k: [first[k], first[k + 1])
+    bool pipelined[NUM_FU_KINDS];
+    int intervals[NUM_OPS];
+    vector<long long> free_at;
+    
+public:
+    FuStats stats;
+    
+    FunctionalUnits() {
+        for (int kind = 0; kind <= NUM_FU_KINDS; kind++) first[kind] = 0;
+    }
+    
+    void init(const MachineConfig& config) {
+        int per_station[NUM_FU_KINDS] = {
+            config.add_stations, config.mult_stations, config.mult_stations,
+            config.load_stations + config.store_stations
+        };
+        first[0] = 0;
+        for (int kind = 0; kind < NUM_FU_KINDS; kind++) {
+            int count = config.fu_count[kind] > 0 ? config.fu_count[kind] : per_station[kind];
+            first[kind + 1] = first[kind] + count;
+            pipelined[kind] = config.fu_pipelined[kind] != 0;
+            stats.busy_cycles[kind].assign(count, 0);
+        }
+        for (int op = 0; op < NUM_OPS; op++) intervals[op] = config.intervals[op];
+        free_at.assign(first[NUM_FU_KINDS], 0);
+    }
+    
+    int count(int kind) const { return first[kind + 1] - first[kind]; }
+    bool isPipelined(int kind) const { return pipelined[kind]; }
+    
+    // Unidade do tipo livre em cycle; -1 se todas estao ocupadas
+    int findFree(FuKind kind, long long cycle) const {
+        for (int unit = first[kind]; unit < first[kind + 1]; unit++) {
+            if (free_at[unit] <= cycle) return unit;
+        }
+        return -1;
+    }
+    
+    // Iniciar op de latencia latency na unidade em cycle; retorna o ciclo em
+    // que a unidade volta a aceitar operacoes
+    long long start(int unit, OpType op, int latency, long long cycle) {
+        FuKind kind = fuKindOf(op);
+        int occupied = pipelined[kind] ? intervals[op] : latency;
+        free_at[unit] = cycle + occupied;
+        stats.busy_cycles[kind][unit - first[kind]] += occupied;
+        stats.operations[kind]++;
+        return free_at[unit];
+    }
+    
+    // Liberar em cycle a unidade de uma operacao descartada que a reservou ate
+    // busy_until: a ocupacao que faltava sai de busy_cycles
+    void release(int unit, long long busy_until, long long cycle) {
+        if (busy_until <= cycle) return;
+        int kind = 0;
+        while (unit >= first[kind + 1]) kind++;
+        stats.busy_cycles[kind][unit - first[kind]] -= busy_until - cycle;
+        free_at[unit] = cycle;
+    }
+    
+    // Fim da simulacao em cycle: a ocupacao reservada alem dele nao conta
+    void finish(long long cycle) {
+        for (int kind = 0; kind < NUM_FU_KINDS; kind++) {
+            for (int unit = first[kind]; unit < first[kind + 1]; unit++) {
+                if (free_at[unit] <= cycle) continue;
+                stats.busy_cycles[kind][unit - first[kind]] -= free_at[unit] - cycle;
+                free_at[unit] = cycle;
+            }
+        }
+    }
+    
+    // Primeiro ciclo, a partir de cycle, com alguma unidade do tipo livre
+    long long nextFree(FuKind kind, long long cycle) const {
+        long long next = numeric_limits<long long>::max();
+        for (int unit = first[kind]; unit < first[kind + 1]; unit++) {
+            next = min(next, max(free_at[unit], cycle));
+        }
+        return next;
+    }
+    
+    template <class Writer>
+    void save(Writer& writer) const {
+        writer.putArray(free_at);
+        for (int kind = 0; kind < NUM_FU_KINDS; kind++) writer.putArray(stats.busy_cycles[kind]);
+        writer.put(stats.operations);
+        writer.put(stats.wait_cycles);
+    }
+    
+    template <class Reader>
+    void restore(Reader& reader) {
+        reader.getArray(free_at);
+        for (int kind = 0; kind < NUM_FU_KINDS; kind++) reader.getArray(stats.busy_cycles[kind]);
+        reader.get(stats.operations);
+        reader.get(stats.wait_cycles);
+    }
+};
+
+// Estatisticas acumuladas por ciclo: motivos de stall da emissao, disputa do
+// CDB, ocupacao do ROB e das estacoes e utilizacao das unidades funcionais
+struct SimulationStats {
+    long long cycles;
+    long long committed;
+    long long stall_fetch_empty;   // Nada a emitir (fim do programa)
+    long long stall_rob_full;      // rob_entries_available == 0
+    long long stall_no_station[NUM_STATION_CLASSES]; // findFreeStation() == -1
+    long long cdb_contention_cycles;  // Ciclos com resultados sem CDB livre
+    long long cdb_waiting_results;    // Soma por ciclo dos resultados em espera
+    long long rob_occupancy_sum;
+    int rob_occupancy_peak;
+    vector<long long> station_histogram[NUM_STATION_CLASSES]; // [k] = ciclos com k ocupadas
+    long long executing_cycles[NUM_STATION_CLASSES];          // Soma por ciclo das execucoes
+    long long operand_wait_cycles[NUM_STATION_CLASSES];       // Soma por ciclo das estacoes aguardando operandos
+    CacheStats cache;                                         // Com caches ligadas (l1_size > 0)
+    LsqStats lsq;
+    BranchStats branch;
+    FuStats fu;
+    
+    SimulationStats() : cycles(0), committed(0), stall_fetch_empty(0), stall_rob_full(0),
+                        cdb_contention_cycles(0), cdb_waiting_results(0),
+                        rob_occupancy_sum(0), rob_occupancy_peak(0) {
+        for (int c = 0; c < NUM_STATION_CLASSES; c++) {
+            stall_no_station[c] = 0;
+            executing_cycles[c] = 0;
+            operand_wait_cycles[c] = 0;
+        }
+    }
+    
+    long long operandWait() const {
+        long long total = 0;
+        for (int c = 0; c < NUM_STATION_CLASSES; c++) total += operand_wait_cycles[c];
+        return total;
+    }
+    
+    long long stallNoStation() const {
+        long long total = 0;
+        for (int c = 0; c < NUM_STATION_CLASSES; c++) total += stall_no_station[c];
+        return total;
+    }
+    
+    double ipc() const { return cycles > 0 ? static_cast<double>(committed) / cycles : 0.0; }
+    
+    double mispredictRate() const {
+        return branch.branches > 0 ? static_cast<double>(branch.mispredictions) / branch.branches : 0.0;
+    }
+    
+    // Fracao dos ciclos em que a unidade nao aceitava outra operacao
+    double fuUtilization(int kind, size_t unit) const { return average(fu.busy_cycles[kind][unit]); }
+    
+    double fuAverageUtilization(int kind) const {
+        long long sum = 0;
+        for (long long busy : fu.busy_cycles[kind]) sum += busy;
+        return fu.busy_cycles[kind].empty() ? 0.0 : average(sum) / fu.busy_cycles[kind].size();
+    }
+    
+    // Fracao dos slots de emissao gastos com instrucoes do caminho errado
+    double wastedSlots(const MachineConfig& config) const {
+        long long slots = cycles * config.issue_width;
+        return slots > 0 ? static_cast<double>(branch.wrong_path) / slots : 0.0;
+    }
+    
+    // Acertos sobre acessos a L1 (faltas secundarias contam como faltas)
+    double l1HitRate() const {
+        long long accesses = cache.l1Accesses();
+        return accesses > 0 ? static_cast<double>(cache.l1_hits) / accesses : 0.0;
+    }
+    
+    double average(long long sum) const { return cycles > 0 ? static_cast<double>(sum) / cycles : 0.0; }
+    
+    double stationAverage(int cls) const {
+        long long sum = 0;
+        for (size_t k = 0; k < station_histogram[cls].size(); k++) sum += k * station_histogram[cls][k];
+        return average(sum);
+    }
+    
+    void writeJson(ostream& out, const MachineConfig& config) const {
+        out << fixed << setprecision(4);
+        out << "{\n";
+        out << "  \"cycles\": " << cycles << ",\n";
+        out << "  \"instructions\": " << committed << ",\n";
+        out << "  \"ipc\": " << ipc() << ",\n";
+        out << "  \"issue_stalls\": {\"fetch_empty\": " << stall_fetch_empty
+            << ", \"rob_full\": " << stall_rob_full << ", \"no_station\": {";
+        for (int c = 0; c < NUM_STATION_CLASSES; c++) {
+            out << (c ? ", " : "") << "\"" << STATION_CLASS_NAMES[c] << "\": " << stall_no_station[c];
+        }
+        out << "}},\n";
+        out << "  \"width\": {\"issue\": " << config.issue_width
+            << ", \"commit\": " << config.commit_width << "},\n";
+        out << "  \"cdb\": {\"count\": " << config.cdb_count
+            << ", \"arbitration\": \"" << CDB_ARBITRATION_NAMES[config.cdb_arbitration] << "\""
+            << ", \"contention_cycles\": " << cdb_contention_cycles
+            << ", \"waiting_results\": " << cdb_waiting_results << "},\n";
+        out << "  \"rob\": {\"size\": " << config.rob_size
+            << ", \"avg_occupancy\": " << average(rob_occupancy_sum)
+            << ", \"peak_occupancy\": " << rob_occupancy_peak << "},\n";
+        if (config.l1_size > 0) {
+            out << "  \"cache\": {\"l1_hits\": " << cache.l1_hits << ", \"l1_misses\": " << cache.l1_misses
+                << ", \"l1_hit_rate\": " << l1HitRate()
+                << ", \"l2_hits\": " << cache.l2_hits << ", \"l2_misses\": " << cache.l2_misses
+                << ", \"mshr_merges\": " << cache.mshr_merges
+                << ", \"mshr_stall_cycles\": " << cache.mshr_stall_cycles << "},\n";
+        }
+        out << "  \"lsq\": {\"loads\": " << lsq.loads << ", \"forwards\": " << lsq.forwards
+            << ", \"speculative_loads\": " << lsq.speculative_loads
+            << ", \"violations\": " << lsq.violations << ", \"squashed\": " << lsq.squashed
+            << ", \"forward_wait_cycles\": " << lsq.forward_wait_cycles << "},\n";
+        out << "  \"branch\": {\"predictor\": \"" << PREDICTOR_NAMES[config.branch_predictor] << "\""
+            << ", \"branches\": " << branch.branches << ", \"taken\": " << branch.taken
+            << ", \"mispredictions\": " << branch.mispredictions
+            << ", \"mispredict_rate\": " << mispredictRate()
+            << ", \"btb_misses\": " << branch.btb_misses << ", \"recoveries\": " << branch.recoveries
+            << ", \"wrong_path\": " << branch.wrong_path
+            << ", \"wasted_issue_slots\": " << wastedSlots(config) << "},\n";
+        out << "  \"functional_units\": {\n";
+        for (int kind = 0; kind < NUM_FU_KINDS; kind++) {
+            out << "    \"" << FU_KIND_NAMES[kind] << "\": {\"count\": " << fu.busy_cycles[kind].size()
+                << ", \"pipelined\": " << (config.fu_pipelined[kind] ? "true" : "false")
+                << ", \"operations\": " << fu.operations[kind] << ", \"wait_cycles\": " << fu.wait_cycles[kind]
+                << ", \"avg_utilization\": " << fuAverageUtilization(kind) << ", \"utilization\": [";
+            for (size_t unit = 0; unit < fu.busy_cycles[kind].size(); unit++) {
+                out << (unit ? ", " : "") << fuUtilization(kind, unit);
+            }
+            out << "]}" << (kind + 1 < NUM_FU_KINDS ? "," : "") << "\n";
+        }
+        out << "  },\n";
+        out << "  \"stations\": {\n";
+        for (int c = 0; c < NUM_STATION_CLASSES; c++) {
+            int count = static_cast<int>(station_histogram[c].size()) - 1;
+            out << "    \"" << STATION_CLASS_NAMES[c] << "\": {\"count\": " << count
+                << ", \"avg_occupancy\": " << stationAverage(c)
+                << ", \"fu_utilization\": " << (count > 0 ? average(executing_cycles[c]) / count : 0.0)
+                << ", \"avg_operand_wait\": " << average(operand_wait_cycles[c])
+                << ", \"occupancy_histogram\": [";
+            for (size_t k = 0; k < station_histogram[c].size(); k++) {
+                out << (k ? ", " : "") << station_histogram[c][k];
+            }
+            out << "]}" << (c + 1 < NUM_STATION_CLASSES ? "," : "") << "\n";
+        }
+        out << "  }\n";
+        out << "}\n";
+    }
+    
+    // Uma metrica por linha: "metrica,valor"
+    void writeCsv(ostream& out, const MachineConfig& config) const {
+        out << fixed << setprecision(4);
+        out << "metric,value\n";
+        out << "cycles," << cycles << "\n";
+        out << "instructions," << committed << "\n";
+        out << "ipc," << ipc() << "\n";
+        out << "stall_fetch_empty," << stall_fetch_empty << "\n";
+        out << "stall_rob_full," << stall_rob_full << "\n";
+        for (int c = 0; c < NUM_STATION_CLASSES; c++) {
+            out << "stall_no_station_" << STATION_CLASS_NAMES[c] << "," << stall_no_station[c] << "\n";
+        }
+        out << "cdb_contention_cycles," << cdb_contention_cycles << "\n";
+        out << "cdb_waiting_results," << cdb_waiting_results << "\n";
+        out << "rob_avg_occupancy," << average(rob_occupancy_sum) << "\n";
+        out << "rob_peak_occupancy," << rob_occupancy_peak << "\n";
+        out << "rob_size," << config.rob_size << "\n";
+        if (config.l1_size > 0) {
+            out << "l1_hits," << cache.l1_hits << "\n";
+            out << "l1_misses," << cache.l1_misses << "\n";
+            out << "l1_hit_rate," << l1HitRate() << "\n";
+            out << "l2_hits," << cache.l2_hits << "\n";
+            out << "l2_misses," << cache.l2_misses << "\n";
+            out << "mshr_merges," << cache.mshr_merges << "\n";
+            out << "mshr_stall_cycles," << cache.mshr_stall_cycles << "\n";
+        }
+        out << "lsq_loads," << lsq.loads << "\n";
+        out << "lsq_forwards," << lsq.forwards << "\n";
+        out << "lsq_speculative_loads," << lsq.speculative_loads << "\n";
+        out << "lsq_violations," << lsq.violations << "\n";
+        out << "lsq_squashed," << lsq.squashed << "\n";
+        out << "lsq_forward_wait_cycles," << lsq.forward_wait_cycles << "\n";
+        out << "branches," << branch.branches << "\n";
+        out << "branches_taken," << branch.taken << "\n";
+        out << "branch_mispredictions," << branch.mispredictions << "\n";
+        out << "branch_mispredict_rate," << mispredictRate() << "\n";
+        out << "branch_btb_misses," << branch.btb_misses << "\n";
+        out << "branch_recoveries," << branch.recoveries << "\n";
+        out << "branch_wrong_path," << branch.wrong_path << "\n";
+        out << "branch_wasted_issue_slots," << wastedSlots(config) << "\n";
+        for (int kind = 0; kind < NUM_FU_KINDS; kind++) {
+            const char* name = FU_KIND_NAMES[kind];
+            out << "fu_" << name << "_count," << fu.busy_cycles[kind].size() << "\n";
+            out << "fu_" << name << "_operations," << fu.operations[kind] << "\n";
+            out << "fu_" << name << "_wait_cycles," << fu.wait_cycles[kind] << "\n";
+            out << "fu_" << name << "_avg_utilization," << fuAverageUtilization(kind) << "\n";
+            for (size_t unit = 0; unit < fu.busy_cycles[kind].size(); unit++) {
+                out << "fu_" << name << "_" << unit << "_utilization," << fuUtilization(kind, unit) << "\n";
+            }
+        }
+        for (int c = 0; c < NUM_STATION_CLASSES; c++) {
+            const char* name = STATION_CLASS_NAMES[c];
+            int count = static_cast<int>(station_histogram[c].size()) - 1;
+            out << name << "_avg_occupancy," << stationAverage(c) << "\n";
+            out << name << "_fu_utilization," << (count > 0 ? average(executing_cycles[c]) / count : 0.0) << "\n";
+            out << name << "_avg_operand_wait," << average(operand_wait_cycles[c]) << "\n";
+            for (size_t k = 0; k < station_histogram[c].size(); k++) {
+                out << name << "_occupancy_" << k << "," << station_histogram[c][k] << "\n";
+            }
+        }
+    }
+};
+
+// Ler a configuracao da maquina gravada num checkpoint, para construir o
+// simulador que vai restaura-lo
+bool readCheckpointConfig(const string& filename, MachineConfig& config, string& error) {
+    CheckpointReader reader;
+    if (!reader.open(filename, error)) return false;
+    string text;
+    reader.getString(text);
+    if (!reader.ok()) {
+        error = "arquivo truncado ou corrompido";
+        return false;
+    }
+    istringstream stream(text);
+    config = MachineConfig();
+    return config.load(stream, filename, error) && config.validate(error);
+}
+
+// Parametros da simulacao amostrada (--sample), em instrucoes
+struct SamplingOptions {
+    long long fast_forward; // Executadas no modo funcional antes de cada janela
+    long long warmup;       // Simuladas em detalhe sem medir, para encher o pipeline
+    long long window;       // Medidas em detalhe
+    
+    SamplingOptions() : fast_forward(0), warmup(0), window(0) {}
+};
+
+// Opcoes de execucao da simulacao
+struct SimulationOptions {
+    long long max_cycles; // Limite de ciclos (0 = sem limite)
+    int print_interval;   // Imprimir estado a cada N ciclos (0 = nunca)
+    bool quiet;           // Suprimir mensagens por ciclo (emissao/commit)
+    bool skip_idle;       // Saltar ciclos em que nada muda ate o proximo evento
+    long long alloc_warmup; // Contar alocacoes apos N ciclos de aquecimento (-1 = nao contar)
+    long long checkpoint_at; // Gravar checkpoint ao fim do ciclo N e parar (-1 = nao gravar)
+    string checkpoint_out;   // Arquivo do checkpoint
+    bool functional;         // Somente o interpretador funcional (--functional)
+    int critical_path_top;   // Analise do caminho critico com as N instrucoes mais criticas (0 = nao)
+    SamplingOptions sampling; // Simulacao amostrada se sampling.window > 0
+    
+    SimulationOptions() : max_cycles(0), print_interval(1), quiet(false), skip_idle(false),
+                          alloc_warmup(-1), checkpoint_at(-1), functional(false), critical_path_top(0) {}
+};
+
+// Quantil 0,975 da distribuicao t de Student com df graus de liberdade
+double studentT975(long long df) {
+    static const double table[] = {
+        0, 12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+        2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+    };
+    if (df < 1) return 0;
+    if (df <= 30) return table[df];
+    if (df <= 60) return 2.000;
+    if (df <= 120) return 1.980;
+    return 1.960;
+}
+
+// Resultado da simulacao amostrada: CPI de cada janela e extrapolacao para o
+// programa inteiro com intervalo de confianca de 95% (t de Student)
+struct SamplingResult {
+    vector<double> window_cpi;
+    long long functional_instructions;
+    long long detailed_instructions; // Inclui aquecimento e esvaziamento
+    long long detailed_cycles;
+    double seconds;
+    
+    SamplingResult() : functional_instructions(0), detailed_instructions(0), detailed_cycles(0),
+                       seconds(0) {}
+    
+    long long totalInstructions() const { return functional_instructions + detailed_instructions; }
+    
+    double meanCpi() const {
+        double sum = 0;
+        for (double cpi : window_cpi) sum += cpi;
+        return window_cpi.empty() ? 0.0 : sum / window_cpi.size();
+    }
+    
+    // Meia largura do intervalo de 95% da media (0 com menos de duas janelas)
+    double cpiHalfWidth() const {
+        long long n = static_cast<long long>(window_cpi.size());
+        if (n < 2) return 0.0;
+        double mean = meanCpi();
+        double squares = 0;
+        for (double cpi : window_cpi) squares += (cpi - mean) * (cpi - mean);
+        return studentT975(n - 1) * sqrt(squares / (n - 1)) / sqrt(static_cast<double>(n));
+    }
+    
+    void print(ostream& out) const {
+        double cpi = meanCpi();
+        double half = cpiHalfWidth();
+        double total = static_cast<double>(totalInstructions());
+        out << "Instrucoes: " << totalInstructions() << " (funcional " << functional_instructions
+            << ", detalhado " << detailed_instructions << " em " << detailed_cycles << " ciclos)\n";
+        out << "Janelas medidas: " << window_cpi.size() << "\n";
+        if (window_cpi.empty()) {
+            out << "Nenhuma janela completa: aumente o programa ou reduza --sample" << endl;
+            return;
+        }
+        out << fixed << setprecision(4);
+        out << "CPI: " << cpi << " +- " << half << " (IC 95%)\n";
+        out << "IPC: " << 1.0 / cpi;
+        if (window_cpi.size() >= 2 && cpi > half) {
+            out << " [" << 1.0 / (cpi + half) << ", " << 1.0 / (cpi - half) << "]";
+        }
+        out << "\n";
+        out << setprecision(0) << "Ciclos estimados: " << cpi * total << " +- " << half * total << "\n";
+        out << setprecision(3) << "Tempo: " << seconds << " s" << endl;
+    }
+};
+
+// Analise do caminho critico (--critical-path). O grafo dinamico tem, para
+// cada instrucao commitada, os nos busca, emissao, inicio e fim da execucao,
+// escrita no CDB e commit, ligados por arestas de ordem (emissao e commit em
+// ordem, janela de busca, entradas do ROB, estacoes liberadas) e de dados
+// (produtor -> consumidor pelas tags do ROB lidas na emissao). O caminho
+// parte do ultimo commit e segue sempre a aresta que chegou por ultimo; os
+// ciclos de cada passo sao atribuidos a uma categoria e a instrucao estatica
+// (pc) em que o caminho estava.
+//
+// As arestas de uma instrucao so alcancam as rob_size + fetch_window
+// anteriores, entao o antecessor de cada no e decidido no commit e so essa
+// janela de registros e guardada. Os nos formam uma arvore (cada um aponta
+// para o seu antecessor); um no fora da janela sem filhos nunca estara no
+// caminho e e descartado, e enquanto a raiz tem um unico filho fora da
+// janela o trecho ja e certo e vai para os totais. A memoria fica limitada a
+// janela mais os trechos ainda nao decididos.
+enum WaitKind {
+    WAIT_FETCH, WAIT_STATION, WAIT_OPERAND, WAIT_UNIT, WAIT_EXECUTE, WAIT_CDB, WAIT_COMMIT
+};
+
+const int NUM_WAIT_KINDS = WAIT_COMMIT + 1;
+const char* const WAIT_KIND_NAMES[NUM_WAIT_KINDS] = {
+    "busca", "estacao", "operando", "unidade", "execucao", "cdb", "commit"
+};
+
+class CriticalPathAnalysis {
+private:
+    enum Node { NODE_FETCH, NODE_ISSUE, NODE_START, NODE_END, NODE_WRITE, NODE_COMMIT };
+    static const int NUM_NODES = NODE_COMMIT + 1;
+    
+    // Ciclos de uma instrucao commitada e os nos dela na arvore
+    struct CommitRecord {
+        long long id;
+        long long pc;
+        OpType op;
+        bool mispredicted;
+        long long fetch, issue, start, end, write, commit;
+        long long producers[2];
+        int nodes[NUM_NODES];
+    };
+    
+    // Somas de um trecho do caminho. Os ciclos por pc vao para um vetor que
+    // soma os pcs repetidos quando cresce demais; clear() mantem a memoria,
+    // entao os trechos reaproveitados nao alocam.
+    struct PathTotals {
+        long long cycles[NUM_WAIT_KINDS];
+        long long dependences;  // Arestas de dados
+        long long instructions; // Arestas para outra instrucao
+        vector<pair<long long, long long>> critical; // (pc, ciclos)
+        size_t compacted;       // Tamanho de critical na ultima compactacao
+        
+        PathTotals() : cycles(), dependences(0), instructions(0), compacted(0) {}
+        
+        void clear() {
+            fill(cycles, cycles + NUM_WAIT_KINDS, 0LL);
+            dependences = instructions = 0;
+            critical.clear();
+            compacted = 0;
+        }
+        
+        void credit(long long pc, long long value) {
+            critical.push_back(make_pair(pc, value));
+            if (critical.size() > 2 * compacted + 64) {
+                sort(critical.begin(), critical.end());
+                size_t size = 0;
+                for (const auto& entry : critical) {
+                    if (size > 0 && critical[size - 1].first == entry.first) critical[size - 1].second += entry.second;
+                    else critical[size++] = entry;
+                }
+                critical.resize(size);
+                compacted = size;
+            }
+        }
+    };
+    
+    // No do grafo ainda nao decidido e a aresta para o antecessor (parent),
+    // com o que ela soma ao caminho; filhos numa lista ligada
+    struct PathNode {
+        int parent;
+        int first_child;
+        int next_sibling;
+        int prev_sibling;
+        bool in_window;       // Registro ainda na janela
+        long long pc;
+        WaitKind kind;
+        long long cycles;
+        bool execute;         // Mais um ciclo de execucao (fim da execucao)
+        bool dependence;      // Aresta de dados
+        bool other_record;    // Aresta para outra instrucao
+        int segment;          // Antecessores absorvidos (em segments; -1 se nenhum)
+    };
+    
+    // Totais por instrucao estatica
+    struct StaticInstruction {
+        Instruction instr;    // Primeira ocorrencia (texto do relatorio)
+        long long count;
+        long long wait[NUM_WAIT_KINDS]; // Soma dos ciclos de cada instancia
+        long long critical;   // Ciclos no caminho critico
+        
+        StaticInstruction() : count(0), wait(), critical(0) {}
+    };
+    
+    long long rob_size;
+    long long fetch_window;
+    vector<CommitRecord> window; // Buffer circular: registro i em window[i % window.size()]
+    long long committed;
+    vector<PathNode> nodes;
+    vector<int> free_nodes;
+    vector<PathTotals> segments;
+    vector<int> free_segments;
+    int root;
+    unordered_map<long long, StaticInstruction> statics;
+    PathTotals path;              // Trecho ja decidido (da primeira busca ate a raiz)
+    
+    CommitRecord& at(long long i) { return window[i % window.size()]; }
+    const CommitRecord& at(long long i) const { return window[i % window.size()]; }
+    long long oldest() const { return max(0LL, committed - static_cast<long long>(window.size())); }
+    
+    static long long time(const CommitRecord& r, Node node) {
+        switch (node) {
+            case NODE_FETCH: return r.fetch;
+            case NODE_ISSUE: return r.issue;
+            case NODE_START: return r.start;
+            case NODE_END: return r.end;
+            case NODE_WRITE: return r.write;
+            case NODE_COMMIT: return r.commit;
+        }
+        return 0;
+    }
+    
+    // Ciclo em que o ultimo operando ficou disponivel (emissao se nenhum
+    // faltava) e o indice do produtor que o entregou (-1 se nenhum)
+    long long readyCycle(const CommitRecord& r, long long& producer) const {
+        long long ready = r.issue;
+        producer = -1;
+        for (long long id : r.producers) {
+            long long p = find(id);
+            if (p >= 0 && at(p).write > ready && at(p).write <= r.start) {
+                ready = at(p).write;
+                producer = p;
+            }
+        }
+        return ready;
+    }
+    
+    // Indice do registro com esse id (-1 se nao commitado ou fora da janela;
+    // um produtor pendente na emissao esta sempre a menos de rob_size)
+    long long find(long long id) const {
+        if (id <= 0) return -1;
+        long long low = oldest();
+        long long high = committed;
+        while (low < high) {
+            long long middle = low + (high - low) / 2;
+            if (at(middle).id < id) low = middle + 1;
+            else high = middle;
+        }
+        return low < committed && at(low).id == id ? low : -1;
+    }
+    
+    // No que chegou por ultimo ao no node do registro i. A primeira busca nao
+    // tem antecessor e devolve ela mesma.
+    void predecessor(long long i, Node node, long long& next, Node& next_node, WaitKind& kind,
+                     bool& dependence) const {
+        const CommitRecord& r = at(i);
+        next = i;
+        next_node = node;
+        kind = WAIT_COMMIT;
+        dependence = false;
+        switch (node) {
+            case NODE_COMMIT:
+                // Pronta antes, commitou so depois das mais antigas
+                if (i > 0 && r.commit > r.write + 1) next--;
+                else next_node = NODE_WRITE;
+                break;
+            case NODE_WRITE:
+                next_node = NODE_END;
+                kind = WAIT_CDB;
+                break;
+            case NODE_END:
+                next_node = NODE_START;
+                kind = WAIT_EXECUTE;
+                break;
+            case NODE_START: {
+                long long producer = -1;
+                readyCycle(r, producer);
+                // A aresta de dados e espera por operando; sem produtor
+                // pendente, o intervalo emissao -> inicio e espera por unidade
+                kind = producer >= 0 ? WAIT_OPERAND : WAIT_UNIT;
+                if (producer >= 0) {
+                    next = producer;
+                    next_node = NODE_WRITE;
+                    dependence = true;
+                } else {
+                    next_node = NODE_ISSUE;
+                }
+                break;
+            }
+            case NODE_ISSUE: {
+                // Emissao em ordem: presa atras da anterior, esperando uma
+                // entrada do ROB ou uma estacao da classe, ou recem-buscada
+                kind = WAIT_STATION;
+                next_node = NODE_FETCH;
+                if (i == 0 || r.issue == r.fetch) break;
+                const CommitRecord& prev = at(i - 1);
+                next_node = NODE_ISSUE;
+                next = i - 1;
+                if (prev.issue >= r.issue - 1) break;
+                if (i >= rob_size && at(i - rob_size).commit == r.issue) {
+                    next = i - rob_size;
+                    next_node = NODE_COMMIT;
+                    break;
+                }
+                bool station = false;
+                for (long long j = i - 1; j >= 0 && j >= i - rob_size; j--) {
+                    if (at(j).end == r.issue - 1 && stationClassOf(at(j).op) == stationClassOf(r.op)) {
+                        next = j;
+                        next_node = NODE_END;
+                        station = true;
+                        break;
+                    }
+                }
+                if (!station && r.fetch >= prev.issue) {
+                    next = i;
+                    next_node = NODE_FETCH;
+                }
+                break;
+            }
+            case NODE_FETCH: {
+                // Buscada junto com a anterior, ou no ciclo do evento que a
+                // liberou: desvio mal previsto resolvido, emissao que abriu
+                // vaga na janela ou broadcast que revelou uma violacao de
+                // ordem na LSQ (busca de novo)
+                kind = WAIT_FETCH;
+                if (i == 0) break;
+                next = i - 1;
+                if (at(i - 1).fetch == r.fetch) break;
+                for (long long j = i - 1; j >= 0 && j >= i - rob_size - fetch_window; j--) {
+                    const CommitRecord& older = at(j);
+                    Node cause = NODE_FETCH;
+                    if (older.op == BRANCH && older.mispredicted && older.end == r.fetch) cause = NODE_END;
+                    else if (older.issue == r.fetch) cause = NODE_ISSUE;
+                    else if (older.write == r.fetch) cause = NODE_WRITE;
+                    if (cause != NODE_FETCH) {
+                        next = j;
+                        next_node = cause;
+                        break;
+                    }
+                }
+                break;
+            }
+        }
+    }
+    
+    // Criar o no node do registro i ligado ao seu antecessor
+    int link(long long i, Node node) {
+        long long next;
+        Node next_node;
+        WaitKind kind;
+        bool dependence;
+        predecessor(i, node, next, next_node, kind, dependence);
+        
+        int index;
+        if (free_nodes.empty()) {
+            index = static_cast<int>(nodes.size());
+            nodes.push_back(PathNode());
+        } else {
+            index = free_nodes.back();
+            free_nodes.pop_back();
+        }
+        const CommitRecord& r = at(i);
+        PathNode& n = nodes[index];
+        n.parent = n.first_child = n.next_sibling = n.prev_sibling = -1;
+        n.in_window = true;
+        n.pc = r.pc;
+        n.kind = kind;
+        n.cycles = 0;
+        n.execute = false;
+        n.dependence = dependence;
+        n.other_record = next != i;
+        n.segment = -1;
+        if (next == i && next_node == node) {
+            root = index;
+            return index;
+        }
+        n.cycles = max(0LL, time(r, node) - time(at(next), next_node));
+        // O ciclo do fim da execucao conta como execucao, nao como CDB (a
+        // latencia e fim - inicio + 1)
+        if (node == NODE_WRITE && n.cycles > 0) {
+            n.execute = true;
+            n.cycles--;
+        }
+        int parent = at(next).nodes[next_node];
+        n.parent = parent;
+        n.next_sibling = nodes[parent].first_child;
+        if (n.next_sibling >= 0) nodes[n.next_sibling].prev_sibling = index;
+        nodes[parent].first_child = index;
+        return index;
+    }
+    
+    // Somar a aresta de um no (e o trecho que ele absorveu) a totals
+    void add(const PathNode& n, PathTotals& totals) {
+        totals.cycles[n.kind] += n.cycles;
+        totals.cycles[WAIT_EXECUTE] += n.execute;
+        if (n.cycles + n.execute > 0) totals.credit(n.pc, n.cycles + n.execute);
+        totals.dependences += n.dependence;
+        totals.instructions += n.other_record;
+        if (n.segment >= 0) {
+            merge(segments[n.segment], totals);
+            free_segments.push_back(n.segment);
+        }
+    }
+    
+    // Passar as somas de from para totals, esvaziando from
+    static void merge(PathTotals& from, PathTotals& totals) {
+        for (int k = 0; k < NUM_WAIT_KINDS; k++) totals.cycles[k] += from.cycles[k];
+        totals.dependences += from.dependences;
+        totals.instructions += from.instructions;
+        for (const auto& entry : from.critical) totals.credit(entry.first, entry.second);
+        from.clear();
+    }
+    
+    // Tirar o no da lista de filhos do antecessor
+    void unlink(int index) {
+        PathNode& n = nodes[index];
+        if (n.prev_sibling >= 0) nodes[n.prev_sibling].next_sibling = n.next_sibling;
+        else nodes[n.parent].first_child = n.next_sibling;
+        if (n.next_sibling >= 0) nodes[n.next_sibling].prev_sibling = n.prev_sibling;
+    }
+    
+    // Um no fora da janela nao ganha mais filhos. Sem filhos ele e descartado
+    // (e o antecessor reavaliado); com um so filho, todo caminho futuro que o
+    // cruza passa por esse filho: a raiz vira o filho com a aresta somada ao
+    // caminho, e um no interno e absorvido pelo filho, que herda a aresta
+    // dele no seu trecho. Assim a arvore guarda so os nos da janela e as
+    // bifurcacoes entre eles, e a memoria nao cresce com a simulacao.
+    void settle(int index) {
+        while (!nodes[index].in_window) {
+            PathNode& n = nodes[index];
+            int child = n.first_child;
+            if (child < 0 && index != root) {
+                if (n.segment >= 0) {
+                    segments[n.segment].clear();
+                    free_segments.push_back(n.segment);
+                }
+                unlink(index);
+                free_nodes.push_back(index);
+                index = n.parent;
+            } else if (child >= 0 && nodes[child].next_sibling < 0) {
+                PathNode& c = nodes[child];
+                if (index == root) {
+                    add(c, path);
+                    c.segment = -1;
+                    c.parent = -1;
+                    free_nodes.push_back(root);
+                    root = index = child;
+                    continue;
+                }
+                if (c.segment < 0) {
+                    if (free_segments.empty()) {
+                        c.segment = static_cast<int>(segments.size());
+                        segments.push_back(PathTotals());
+                    } else {
+                        c.segment = free_segments.back();
+                        free_segments.pop_back();
+                    }
+                }
+                // O trecho maior fica no filho (a soma custa o menor)
+                if (n.segment >= 0 &&
+                    segments[n.segment].critical.size() > segments[c.segment].critical.size()) {
+                    swap(n.segment, c.segment);
+                }
+                add(n, segments[c.segment]);
+                c.parent = n.parent;
+                c.prev_sibling = n.prev_sibling;
+                c.next_sibling = n.next_sibling;
+                if (c.prev_sibling >= 0) nodes[c.prev_sibling].next_sibling = child;
+                else nodes[c.parent].first_child = child;
+                if (c.next_sibling >= 0) nodes[c.next_sibling].prev_sibling = child;
+                free_nodes.push_back(index);
+                break;
+            } else {
+                break;
+            }
+        }
+    }
+    
+public:
+    CriticalPathAnalysis() : rob_size(0), fetch_window(0), committed(0), root(-1) {}
+    
+    // Tamanhos que limitam o alcance das arestas (antes do primeiro registro)
+    void init(long long rob, long long fetch) {
+        rob_size = rob;
+        fetch_window = fetch;
+        window.assign(rob_size + fetch_window + 1, CommitRecord());
+        nodes.reserve(4 * NUM_NODES * window.size());
+    }
+    
+    bool empty() const { return committed == 0; }
+    
+    // Registrar uma instrucao no commit. Os ciclos de espera dela somam
+    // commit - busca: estacao (busca -> emissao), operando (emissao -> ultimo
+    // operando), unidade (operandos -> inicio: unidade funcional, MSHR ou
+    // ordem de memoria), execucao (latencia), cdb (fim -> broadcast) e commit
+    // (broadcast -> commit, esperando as mais antigas)
+    void record(const Instruction& instr) {
+        long long i = committed;
+        CommitRecord& r = at(i);
+        if (i >= static_cast<long long>(window.size())) {
+            // O registro que sai da janela nao recebe mais arestas. Do
+            // ultimo no ao primeiro: os antecessores de um no do registro
+            // que ele pode descartar ainda estao marcados na janela.
+            for (int node = NODE_COMMIT; node >= NODE_FETCH; node--) {
+                nodes[r.nodes[node]].in_window = false;
+                settle(r.nodes[node]);
+            }
+        }
+        r.id = instr.id;
+        r.pc = instr.pc;
+        r.op = instr.op;
+        r.mispredicted = instr.mispredicted;
+        r.fetch = instr.fetch_cycle;
+        r.issue = instr.issue_cycle;
+        r.start = instr.exec_start_cycle;
+        r.end = instr.exec_end_cycle;
+        r.write = instr.write_cycle;
+        r.commit = instr.commit_cycle;
+        r.producers[0] = instr.producers[0];
+        r.producers[1] = instr.producers[1];
+        committed++;
+        
+        long long producer = -1;
+        long long ready = readyCycle(r, producer);
+        StaticInstruction& entry = statics[r.pc];
+        if (entry.count++ == 0) entry.instr = instr;
+        entry.wait[WAIT_STATION] += r.issue - r.fetch;
+        entry.wait[WAIT_OPERAND] += ready - r.issue;
+        entry.wait[WAIT_UNIT] += r.start - ready;
+        entry.wait[WAIT_EXECUTE] += r.end - r.start + 1;
+        entry.wait[WAIT_CDB] += r.write - r.end - 1;
+        entry.wait[WAIT_COMMIT] += r.commit - r.write;
+        
+        // Cada no aponta para um anterior ou do mesmo registro ja criado
+        for (int node = NODE_FETCH; node <= NODE_COMMIT; node++) {
+            r.nodes[node] = link(i, static_cast<Node>(node));
+        }
+    }
+    
+    // Fechar o caminho: do ultimo commit ate a raiz, o resto ja foi somado
+    void analyze() {
+        if (committed == 0) return;
+        path.instructions++;
+        for (int index = at(committed - 1).nodes[NODE_COMMIT]; index != root; index = nodes[index].parent) {
+            add(nodes[index], path);
+        }
+        for (const auto& entry : path.critical) statics[entry.first].critical += entry.second;
+        path.critical.clear();
+    }
+    
+    long long pathLength() const {
+        long long total = 0;
+        for (long long cycles : path.cycles) total += cycles;
+        return total;
+    }
+    
+    // Relatorio: composicao do caminho critico, espera media por instrucao
+    // e as top instrucoes estaticas com mais ciclos no caminho
+    void print(ostream& out, int top) const {
+        long long length = pathLength();
+        double instructions = static_cast<double>(committed);
+        out << "\n========== CAMINHO CRITICO ==========\n";
+        out << "Comprimento: " << length << " ciclos, " << path.instructions << " instrucoes, "
+            << path.dependences << " dependencias de dados\n";
+        out << "Composicao:" << fixed << setprecision(1);
+        for (int k = 0; k < NUM_WAIT_KINDS; k++) {
+            out << (k ? ", " : " ") << WAIT_KIND_NAMES[k] << ' '
+                << (length > 0 ? 100.0 * path.cycles[k] / length : 0.0) << '%';
+        }
+        out << "\nCiclos medios por instrucao:" << setprecision(2);
+        for (int k = WAIT_STATION; k < NUM_WAIT_KINDS; k++) {
+            long long sum = 0;
+            for (const auto& entry : statics) sum += entry.second.wait[k];
+            out << (k > WAIT_STATION ? ", " : " ") << WAIT_KIND_NAMES[k] << ' '
+                << (instructions > 0 ? sum / instructions : 0.0);
+        }
+        out << "\n";
+        
+        vector<const pair<const long long, StaticInstruction>*> ranked;
+        for (const auto& entry : statics) ranked.push_back(&entry);
+        sort(ranked.begin(), ranked.end(), [](const pair<const long long, StaticInstruction>* a,
+                                              const pair<const long long, StaticInstruction>* b) {
+            if (a->second.critical != b->second.critical) return a->second.critical > b->second.critical;
+            return a->first < b->first;
+        });
+        if (ranked.size() > static_cast<size_t>(top)) ranked.resize(top);
+        out << "Instrucoes estaticas com mais ciclos no caminho (medias por execucao):\n";
+        out << setw(6) << "pc" << "  " << left << setw(20) << "instrucao" << right << setw(10) << "execucoes"
+            << setw(10) << "caminho" << setw(7) << "%";
+        for (int k = WAIT_STATION; k < NUM_WAIT_KINDS; k++) out << setw(10) << WAIT_KIND_NAMES[k];
+        out << "\n";
+        for (const auto* entry : ranked) {
+            const StaticInstruction& info = entry->second;
+            StringSink text;
+            writeInstructionText(text, info.instr);
+            out << setw(6) << entry->first << "  " << left << setw(20) << text.text << right
+                << setw(10) << info.count << setw(10) << info.critical << setprecision(1) << setw(7)
+                << (length > 0 ? 100.0 * info.critical / length : 0.0) << setprecision(2);
+            for (int k = WAIT_STATION; k < NUM_WAIT_KINDS; k++) {
+                out << setw(10) << static_cast<double>(info.wait[k]) / info.count;
+            }
+            out << "\n";
+        }
+    }
+};
+
+// Parametros da maquina vistos pelo nucleo do simulador. RuntimeMachine le os
+// valores de MachineConfig em tempo de execucao e guarda o estado em vector;
+// StaticMachine fixa os mesmos valores como constexpr e guarda o estado em
+// std::array, de modo que o compilador resolve latencias, larguras e limites
+// de classe como constantes. Ambos expoem a mesma interface, e o nucleo e
+// um so: os resultados das duas versoes sao identicos.
+struct RuntimeMachine {
+    template <class T, size_t N>
+    using Array = vector<T>;
+    static const size_t MAX_STATIONS = 0; // Tamanho decidido em init()
+    static const size_t MAX_ROB = 0;
+    
+    MachineConfig config;
+    int class_begin[NUM_STATION_CLASSES + 1];
+    
+    RuntimeMachine(const MachineConfig& machine = MachineConfig()) : config(machine) {
+        int counts[NUM_STATION_CLASSES] = {
+            config.add_stations, config.mult_stations, config.load_stations, config.store_stations
+        };
+        class_begin[0] = 0;
+        for (int c = 0; c < NUM_STATION_CLASSES; c++) class_begin[c + 1] = class_begin[c] + counts[c];
+    }
+    
+    int classBegin(int c) const { return class_begin[c]; }
+    int stationCount(int c) const { return class_begin[c + 1] - class_begin[c]; }
+    int latency(OpType op) const { return config.latencies[op]; }
+    int robSize() const { return config.rob_size; }
+    int issueWidth() const { return config.issue_width; }
+    int commitWidth() const { return config.commit_width; }
+    int cdbCount() const { return config.cdb_count; }
+    CdbArbitration cdbArbitration() const { return static_cast<CdbArbitration>(config.cdb_arbitration); }
+    uint64_t memoryWords() const { return config.memoryWords(); }
+    MachineConfig configuration() const { return config; }
+};
+
+template <int AddStations, int MultStations, int LoadStations, int StoreStations,
+          int LatencyAdd, int LatencySub, int LatencyMul, int LatencyDiv,
+          int LatencyLoad, int LatencyStore, int LatencyBranch, int RobSize,
+          int IssueWidth, int CommitWidth, int CdbCount, CdbArbitration Arbitration,
+          int MemorySize>
+struct StaticMachine {
+    static_assert(AddStations >= 1 && MultStations >= 1 && LoadStations >= 1 && StoreStations >= 1,
+                  "cada classe precisa de ao menos uma estacao");
+    static_assert(LatencyAdd >= 1 && LatencySub >= 1 && LatencyMul >= 1 && LatencyDiv >= 1 &&
+                  LatencyLoad >= 1 && LatencyStore >= 1 && LatencyBranch >= 1, "latencias devem ser >= 1");
+    static_assert(RobSize >= 1 && IssueWidth >= 1 && CommitWidth >= 1 && CdbCount >= 1 &&
+                  MemorySize >= 1, "tamanhos e larguras devem ser >= 1");
+    
+    template <class T, size_t N>
+    using Array = array<T, N>;
+    static const size_t MAX_STATIONS = AddStations + MultStations + LoadStations + StoreStations;
+    static const size_t MAX_ROB = RobSize;
+    
+    static constexpr int classBegin(int c) {
+        return c <= ADD_CLASS ? 0
+             : c == MULT_CLASS ? AddStations
+             : c == LOAD_CLASS ? AddStations + MultStations
+             : c == STORE_CLASS ? AddStations + MultStations + LoadStations
+             : static_cast<int>(MAX_STATIONS);
+    }
+    static constexpr int stationCount(int c) { return classBegin(c + 1) - classBegin(c); }
+    static constexpr int latency(OpType op) {
+        return op == ADD ? LatencyAdd : op == SUB ? LatencySub : op == MUL ? LatencyMul
+             : op == DIV ? LatencyDiv : op == LOAD ? LatencyLoad : op == STORE ? LatencyStore
+             : LatencyBranch;
+    }
+    static constexpr int robSize() { return RobSize; }
+    static constexpr int issueWidth() { return IssueWidth; }
+    static constexpr int commitWidth() { return CommitWidth; }
+    static constexpr int cdbCount() { return CdbCount; }
+    static constexpr CdbArbitration cdbArbitration() { return Arbitration; }
+    static constexpr uint64_t memoryWords() { return MemorySize; }
+    
+    // Configuracao equivalente, para impressao, estatisticas e comparacao com
+    // a configuracao pedida na linha de comando
+    static MachineConfig configuration() {
+        MachineConfig config;
+        config.add_stations = AddStations;
+        config.mult_stations = MultStations;
+        config.load_stations = LoadStations;
+        config.store_stations = StoreStations;
+        config.latencies[ADD] = LatencyAdd;
+        config.latencies[SUB] = LatencySub;
+        config.latencies[MUL] = LatencyMul;
+        config.latencies[DIV] = LatencyDiv;
+        config.latencies[LOAD] = LatencyLoad;
+        config.latencies[STORE] = LatencyStore;
+        config.latencies[BRANCH] = LatencyBranch;
+        config.rob_size = RobSize;
+        config.issue_width = IssueWidth;
+        config.commit_width = CommitWidth;
+        config.cdb_count = CdbCount;
+        config.cdb_arbitration = Arbitration;
+        config.memory_size = MemorySize;
+        return config;
+    }
+};
+
+// Modelo de producao compilado com parametros fixos (--static): a configuracao
+// padrao de MachineConfig
+typedef StaticMachine<3, 2, 2, 2, 2, 2, 10, 40, 3, 3, 1, 16, 1, 1, 1, CDB_OLDEST, 1024> FixedMachine;
+
+template <class Machine = RuntimeMachine>
+class TomasuloSimulator {
+private:
+    // Parametros da maquina (constantes em tempo de compilacao com StaticMachine)
+    Machine machine;
+    
+    // Estações de reserva
+    StationTable<Machine> stations;
+    
+    // Banco de registradores (indexado pelo id resolvido em loadInstructions)
+    Register registers[NUM_REGS];
+    
+    // Busca de instrucoes sob demanda: a janela guarda apenas as proximas
+    // instrucoes a emitir; as emitidas ficam em rob_instructions ate o commit.
+    // A busca segue a previsao dos desvios (predictor) e volta ao caminho
+    // correto quando um desvio previsto errado termina a execucao.
+    unique_ptr<InstructionSource> source;
+    string trace_filename;                // Reaberto ao restaurar um checkpoint
+    long long fetched_count;              // Instrucoes buscadas (id da ultima)
+    BranchPredictor predictor;
+    RingBuffer<Instruction> fetch_buffer;
+    size_t fetch_window;
+    typename Machine::template Array<Instruction, Machine::MAX_ROB> rob_instructions; // Registro de tempos por entrada do ROB
+    ostream* timing_out;                  // Destino dos registros no commit (opcional)
+    BufferedWriter* pipeview_out;         // Linha do tempo de cada instrucao (--pipeview)
+    BufferedWriter* delta_out;            // Mudancas de estado por ciclo em JSON (--deltas)
+    
+    // Estado da ultima linha de --deltas, comparado ao fim de cada ciclo
+    typename Machine::template Array<long long, Machine::MAX_STATIONS> delta_station_ids; // 0 = livre, -1 = emitida no ciclo
+    Register delta_registers[NUM_REGS];
+    int delta_rob_head;
+    int delta_rob_tail;
+    vector<pair<Address, float>> delta_writes; // STOREs commitados no ciclo
+    long long fetch_seq;                  // Ultimo Instruction::seq atribuido
+    
+    // Controle de ciclos
+    long long current_cycle;
+    
+    // Configuração da máquina (estações, latências, ROB, memória, CDB), para
+    // impressao; o comportamento le os parametros de machine
+    MachineConfig config;
+    
+    // Memória simulada e caches de dados
+    SparseMemory memory;
+    CacheHierarchy cache;
+    int mshr_waiting; // Instrucoes prontas que nao iniciaram por falta de MSHR
+    
+    // Unidades funcionais e instrucoes prontas sem unidade livre, por tipo
+    FunctionalUnits units;
+    int fu_waiting[NUM_FU_KINDS];
+    int unit_waiting; // Soma de fu_waiting
+    
+    // Instrucoes em execucao (min-heap por ciclo de conclusao)
+    vector<ExecutingInstruction> executing_instructions;
+    long long exec_seq;
+    
+    // Estacoes com operandos prontos aguardando inicio da execucao
+    vector<int> ready_queue;
+    
+    // Fila de loads/stores: tags do ROB dos LOADs e STOREs em voo, em ordem de
+    // programa. STOREs gravam a memoria so no commit; LOADs recebem o dado do
+    // STORE mais antigo de mesmo endereco ou leem a memoria (ver startLoad)
+    RingBuffer<int> load_queue;
+    RingBuffer<int> store_queue;
+    int forward_waiting;         // LOADs prontos esperando o dado de um STORE
+    vector<int> memory_wakeups;  // LOAD/STORE que receberam operando no broadcast
+    
+    // Reorder Buffer (ROB)
+    ReorderBuffer<Machine> rob;
+    int rob_size;
+    int rob_head;
+    int rob_tail;
+    int rob_entries_available;
+    
+    // Fila de instruções completadas aguardando CDB
+    RingBuffer<CDBEntry> completed_for_cdb;
+    
+    // Saida de mensagens/estado desta instancia e gerador aleatorio proprio,
+    // para que varias simulacoes rodem em paralelo no mesmo processo
+    ostream* out;
+    mt19937 rng;
+    
+    // Opcoes da execucao corrente e contadores do resumo final
+    SimulationOptions options;
+    long long committed_count;
+    long long div_by_zero_count;
+    long long memory_fault_count; // LOAD/STORE com endereco fora da memoria
+    long long idle_cycles_skipped;
+    
+    // Modo --count-allocs: contador de alocacoes ao fim do aquecimento e ao fim
+    // da simulacao (alloc_start_cycle = -1 enquanto o aquecimento nao termina),
+    // e o das feitas ao criar paginas da memoria, que ficam fora da contagem
+    long long alloc_start_count;
+    long long alloc_start_cycle;
+    long long alloc_end_count;
+    long long alloc_start_pages;
+    long long alloc_end_pages;
+    
+    // Checkpoint gravado nesta execucao (--checkpoint-at)
+    bool checkpoint_written;
+    
+    // Amostragem: instrucoes executadas no modo funcional e emissao suspensa
+    // enquanto o pipeline esvazia ao fim de uma janela detalhada
+    long long functional_count;
+    bool issue_enabled;
+    
+    // Estatisticas e contadores de ocupacao mantidos incrementalmente
+    SimulationStats stats;
+    CriticalPathAnalysis critical_path; // Registros do commit (--critical-path)
+    IssueStall issue_stall;
+    StationClass issue_stall_class; // Classe sem estacao livre (STALL_NO_STATION)
+    int busy_stations[NUM_STATION_CLASSES];
+    int executing_count[NUM_STATION_CLASSES];
+
+public:
+    explicit TomasuloSimulator(const Machine& parameters = Machine(),
+                               unsigned seed = static_cast<unsigned>(time(0)),
+                               ostream& output = cout)
+        : machine(parameters), fetched_count(0), fetch_window(0), timing_out(nullptr), pipeview_out(nullptr),
+          delta_out(nullptr), delta_rob_head(0), delta_rob_tail(0), fetch_seq(0), current_cycle(1),
+          config(parameters.configuration()), mshr_waiting(0), exec_seq(0), forward_waiting(0),
+          out(&output), rng(seed), committed_count(0), div_by_zero_count(0),
+          memory_fault_count(0),
+          idle_cycles_skipped(0), alloc_start_count(0), alloc_start_cycle(-1), alloc_end_count(0),
+          alloc_start_pages(0), alloc_end_pages(0),
+          checkpoint_written(false), functional_count(0), issue_enabled(true), issue_stall(STALL_NONE),
+          issue_stall_class(ADD_CLASS) {
+        // Inicializar estações de reserva
+        stations.init(machine);
+        for (int c = 0; c < NUM_STATION_CLASSES; c++) {
+            stats.station_histogram[c].assign(machine.stationCount(c) + 1, 0);
+            busy_stations[c] = 0;
+            executing_count[c] = 0;
+        }
+        
+        // Inicializar ROB
+        rob_size = machine.robSize();
+        rob.init(rob_size, stations.words());
+        size_t total_stations = stations.size();
+        rob_head = 0;
+        rob_tail = 0;
+        rob_entries_available = rob_size;
+        resetArray(rob_instructions, rob_size, Instruction());
+        fetch_window = rob_size;
+        
+        // Filas do ciclo com capacidade maxima ja reservada: cada estacao tem no
+        // maximo uma instrucao executando ou pronta, e cada resultado a espera
+        // do CDB ocupa uma entrada do ROB. A janela de busca recebe de volta
+        // ate um ROB inteiro de instrucoes descartadas (squash)
+        fetch_buffer.reserve(fetch_window + rob_size);
+        completed_for_cdb.reserve(rob_size);
+        executing_instructions.reserve(total_stations);
+        ready_queue.reserve(total_stations);
+        memory_wakeups.reserve(total_stations);
+        load_queue.reserve(rob_size);
+        store_queue.reserve(rob_size);
+        
+        // Inicializar registradores com valores aleatórios
+        for (int i = 0; i < REGS_PER_BANK; i++) {
+            float random_value = (rng() % 10) * 10.0;
+            registers[i].value = random_value;
+            registers[REGS_PER_BANK + i].value = random_value;
+        }
+        
+        // Inicializar memória
+        memory.init(machine.memoryWords());
+        cache.init(config);
+        predictor.init(config);
+        units.init(config);
+        for (int kind = 0; kind < NUM_FU_KINDS; kind++) fu_waiting[kind] = 0;
+        unit_waiting = 0;
+    }
+    
+    // Abrir arquivo de instrucoes (texto ou trace binario) para leitura sob demanda
+    bool loadInstructions(const string& filename) {
+        trace_filename = filename;
+        if (isBinaryTrace(filename)) {
+            unique_ptr<BinaryInstructionSource> binary(new BinaryInstructionSource());
+            string error;
+            if (!binary->open(filename, error)) {
+                *out << "Erro: trace binario " << filename << ": " << error << endl;
+                return false;
+            }
+            source = move(binary);
+            fetchInstructions();
+            return true;
+        }
+        
+        unique_ptr<TextInstructionSource> text(new TextInstructionSource());
+        string error;
+        if (!text->open(filename, error)) {
+            *out << "Erro: " << filename << ": " << error << endl;
+            return false;
+        }
+        source = move(text);
+        fetchInstructions();
+        return true;
+    }
+    
+    // Gravar o estado completo entre dois ciclos: maquina, estacoes, ROB,
+    // registradores, memoria, filas, estatisticas, gerador aleatorio e a
+    // posicao de leitura do trace (as instrucoes ja buscadas vao na janela)
+    bool saveCheckpoint(const string& filename, string& error) {
+        CheckpointWriter writer;
+        if (!writer.open(filename)) {
+            error = "nao foi possivel criar o arquivo";
+            return false;
+        }
+        writer.putString(config.toString());
+        writer.putString(trace_filename);
+        writer.put(fileSize(trace_filename));
+        writer.put(source ? source->cursor() : -1LL);
+        writer.put(source ? source->pc() : 0LL);
+        writer.put(fetched_count);
+        writer.put(fetch_seq);
+        writer.put(current_cycle);
+        
+        writer.putArray(stations.busy);
+        writer.putArray(stations.op);
+        writer.putArray(stations.instr_id);
+        writer.putArray(stations.vj);
+        writer.putArray(stations.vk);
+        writer.putArray(stations.qj);
+        writer.putArray(stations.qk);
+        writer.putArray(stations.dest);
+        writer.putArray(stations.dest_reg);
+        writer.putArray(stations.address);
+        
+        writer.putArray(rob.busy);
+        writer.putArray(rob.instruction_index);
+        writer.putArray(rob.type);
+        writer.putArray(rob.state);
+        writer.putArray(rob.destination_register);
+        writer.putArray(rob.value);
+        writer.putArray(rob.address);
+        writer.putArray(rob.value_ready);
+        writer.putArray(rob.address_ready);
+        writer.putArray(rob.loaded);
+        writer.putArray(rob.load_source);
+        writer.putArray(rob.div_by_zero);
+        writer.putArray(rob.consumers);
+        writer.put(rob_head);
+        writer.put(rob_tail);
+        writer.put(rob_entries_available);
+        writer.putArray(rob_instructions);
+        
+        writer.put(registers);
+        memory.save(writer);
+        cache.save(writer);
+        writer.put(mshr_waiting);
+        predictor.save(writer);
+        units.save(writer);
+        writer.put(fu_waiting);
+        writer.put(unit_waiting);
+        
+        writer.put(static_cast<uint64_t>(fetch_buffer.size()));
+        for (size_t i = 0; i < fetch_buffer.size(); i++) writer.put(fetch_buffer[i]);
+        writer.put(static_cast<uint64_t>(completed_for_cdb.size()));
+        for (size_t i = 0; i < completed_for_cdb.size(); i++) writer.put(completed_for_cdb[i]);
+        writer.put(static_cast<uint64_t>(executing_instructions.size()));
+        for (const ExecutingInstruction& exec : executing_instructions) writer.put(exec);
+        writer.put(exec_seq);
+        writer.put(static_cast<uint64_t>(ready_queue.size()));
+        for (int station : ready_queue) writer.put(station);
+        writer.put(static_cast<uint64_t>(load_queue.size()));
+        for (size_t i = 0; i < load_queue.size(); i++) writer.put(load_queue[i]);
+        writer.put(static_cast<uint64_t>(store_queue.size()));
+        for (size_t i = 0; i < store_queue.size(); i++) writer.put(store_queue[i]);
+        writer.put(forward_waiting);
+        
+        ostringstream rng_state;
+        rng_state << rng;
+        writer.putString(rng_state.str());
+        writer.put(committed_count);
+        writer.put(div_by_zero_count);
+        writer.put(memory_fault_count);
+        writer.put(idle_cycles_skipped);
+        writer.put(issue_stall);
+        writer.put(issue_stall_class);
+        writer.put(busy_stations);
+        writer.put(executing_count);
+        
+        writer.put(stats.stall_fetch_empty);
+        writer.put(stats.stall_rob_full);
+        writer.put(stats.stall_no_station);
+        writer.put(stats.cdb_contention_cycles);
+        writer.put(stats.cdb_waiting_results);
+        writer.put(stats.rob_occupancy_sum);
+        writer.put(stats.rob_occupancy_peak);
+        for (int c = 0; c < NUM_STATION_CLASSES; c++) writer.putArray(stats.station_histogram[c]);
+        writer.put(stats.executing_cycles);
+        writer.put(stats.operand_wait_cycles);
+        writer.put(stats.lsq);
+        writer.put(stats.branch);
+        
+        if (!writer.close()) {
+            error = "falha ao gravar o arquivo";
+            return false;
+        }
+        return true;
+    }
+    
+    // Restaurar um checkpoint gravado por saveCheckpoint() com a mesma maquina
+    // (ver readCheckpointConfig). O trace e reaberto pelo caminho gravado ou
+    // por trace_override, e precisa ter o mesmo tamanho do original.
+    bool restoreCheckpoint(const string& filename, const string& trace_override, string& error) {
+        CheckpointReader reader;
+        if (!reader.open(filename, error)) return false;
+        string machine_text;
+        reader.getString(machine_text);
+        if (reader.ok() && machine_text != config.toString()) {
+            error = "checkpoint gravado com outra configuracao da maquina";
+            return false;
+        }
+        string trace;
+        long long trace_size = -1;
+        long long trace_cursor = -1;
+        long long trace_pc = 0;
+        long long fetched = 0;
+        long long seq = 0;
+        reader.getString(trace);
+        reader.get(trace_size);
+        reader.get(trace_cursor);
+        reader.get(trace_pc);
+        reader.get(fetched);
+        reader.get(seq);
+        reader.get(current_cycle);
+        if (!reader.ok()) {
+            error = "arquivo truncado ou corrompido";
+            return false;
+        }
+        if (!trace_override.empty()) trace = trace_override;
+        if (fileSize(trace) != trace_size) {
+            error = "trace " + trace + " ausente ou diferente do usado no checkpoint";
+            return false;
+        }
+        // loadInstructions() ja preenche a janela do inicio do trace; ela e o
+        // historico do preditor sao substituidos pelos gravados logo abaixo
+        if (!loadInstructions(trace) || !source->seek(trace_cursor, trace_pc)) {
+            error = "nao foi possivel reposicionar o trace " + trace;
+            return false;
+        }
+        fetched_count = fetched;
+        fetch_seq = seq;
+        
+        reader.getArray(stations.busy);
+        reader.getArray(stations.op);
+        reader.getArray(stations.instr_id);
+        reader.getArray(stations.vj);
+        reader.getArray(stations.vk);
+        reader.getArray(stations.qj);
+        reader.getArray(stations.qk);
+        reader.getArray(stations.dest);
+        reader.getArray(stations.dest_reg);
+        reader.getArray(stations.address);
+        
+        reader.getArray(rob.busy);
+        reader.getArray(rob.instruction_index);
+        reader.getArray(rob.type);
+        reader.getArray(rob.state);
+        reader.getArray(rob.destination_register);
+        reader.getArray(rob.value);
+        reader.getArray(rob.address);
+        reader.getArray(rob.value_ready);
+        reader.getArray(rob.address_ready);
+        reader.getArray(rob.loaded);
+        reader.getArray(rob.load_source);
+        reader.getArray(rob.div_by_zero);
+        reader.getArray(rob.consumers);
+        reader.get(rob_head);
+        reader.get(rob_tail);
+        reader.get(rob_entries_available);
+        reader.getArray(rob_instructions);
+        
+        reader.get(registers);
+        if (!memory.restore(reader)) {
+            error = "memoria do checkpoint invalida";
+            return false;
+        }
+        cache.restore(reader);
+        reader.get(mshr_waiting);
+        predictor.restore(reader);
+        units.restore(reader);
+        reader.get(fu_waiting);
+        reader.get(unit_waiting);
+        
+        // Filas: o tamanho gravado nao pode passar da capacidade reservada
+        uint64_t count = 0;
+        reader.get(count);
+        fetch_buffer.clear();
+        for (uint64_t i = 0; reader.ok() && i < count && !fetch_buffer.full(); i++) {
+            Instruction instr;
+            reader.get(instr);
+            fetch_buffer.push_back(instr);
+        }
+        bool sizes_ok = fetch_buffer.size() == count;
+        reader.get(count);
+        completed_for_cdb.clear();
+        for (uint64_t i = 0; reader.ok() && i < count && !completed_for_cdb.full(); i++) {
+            CDBEntry entry;
+            reader.get(entry);
+            completed_for_cdb.push_back(entry);
+        }
+        sizes_ok &= completed_for_cdb.size() == count;
+        reader.get(count);
+        executing_instructions.clear();
+        for (uint64_t i = 0; reader.ok() && i < count && i < executing_instructions.capacity(); i++) {
+            ExecutingInstruction exec(0, 0, 0, 0, 0, 0);
+            reader.get(exec);
+            executing_instructions.push_back(exec);
+        }
+        sizes_ok &= executing_instructions.size() == count;
+        reader.get(exec_seq);
+        reader.get(count);
+        ready_queue.clear();
+        for (uint64_t i = 0; reader.ok() && i < count && i < ready_queue.capacity(); i++) {
+            int station = 0;
+            reader.get(station);
+            ready_queue.push_back(station);
+        }
+        sizes_ok &= ready_queue.size() == count;
+        RingBuffer<int>* memory_queues[] = {&load_queue, &store_queue};
+        for (RingBuffer<int>* queue : memory_queues) {
+            reader.get(count);
+            queue->clear();
+            for (uint64_t i = 0; reader.ok() && i < count && !queue->full(); i++) {
+                int tag = 0;
+                reader.get(tag);
+                queue->push_back(tag);
+            }
+            sizes_ok &= queue->size() == count;
+        }
+        reader.get(forward_waiting);
+        
+        string rng_state;
+        reader.getString(rng_state);
+        istringstream(rng_state) >> rng;
+        reader.get(committed_count);
+        reader.get(div_by_zero_count);
+        reader.get(memory_fault_count);
+        reader.get(idle_cycles_skipped);
+        reader.get(issue_stall);
+        reader.get(issue_stall_class);
+        reader.get(busy_stations);
+        reader.get(executing_count);
+        
+        reader.get(stats.stall_fetch_empty);
+        reader.get(stats.stall_rob_full);
+        reader.get(stats.stall_no_station);
+        reader.get(stats.cdb_contention_cycles);
+        reader.get(stats.cdb_waiting_results);
+        reader.get(stats.rob_occupancy_sum);
+        reader.get(stats.rob_occupancy_peak);
+        for (int c = 0; c < NUM_STATION_CLASSES; c++) reader.getArray(stats.station_histogram[c]);
+        reader.get(stats.executing_cycles);
+        reader.get(stats.operand_wait_cycles);
+        reader.get(stats.lsq);
+        reader.get(stats.branch);
+        
+        if (!reader.ok() || !sizes_ok) {
+            error = "arquivo truncado ou corrompido";
+            return false;
+        }
+        return true;
+    }
+    
+    // Valores iniciais da memoria (--memory-init)
+    bool initializeMemory(const string& filename, string& error) {
+        return memory.load(filename, error);
+    }
+    
+    // Gravar "endereco valor" das palavras nao nulas das paginas modificadas
+    // pelo programa (--memory-dump), no formato aceito por --memory-init
+    void dumpMemory(ostream& dump) const {
+        dump << "# " << memory.dirtyPageCount() << " paginas modificadas de " << memory.pageCount()
+             << " alocadas (" << SparseMemory::PAGE_WORDS << " palavras por pagina)\n";
+        dump << setprecision(9);
+        memory.forEachWord(true, [&dump](Address address, float value) {
+            dump << address << ' ' << value << '\n';
+        });
+    }
+    
+    // Enviar registro de tempos de cada instrucao commitada para o destino dado
+    void setTimingOutput(ostream* out) {
+        timing_out = out;
+        if (timing_out) {
+            *timing_out << "id,op,issue,exec_start,exec_end,write,commit\n";
+        }
+    }
+    
+    // Gravar a linha do tempo das instrucoes no formato O3PipeView (gem5),
+    // lido pelo o3-pipeview.py e pelo Konata
+    void setPipeViewOutput(BufferedWriter* out) {
+        pipeview_out = out;
+    }
+    
+    // Gravar, em vez do estado completo, so o que mudou em cada ciclo (uma
+    // linha JSON por ciclo com mudancas). A primeira linha e o estado atual
+    // completo, com "baseline": true.
+    void setDeltaOutput(BufferedWriter* out) {
+        delta_out = out;
+        resetArray(delta_station_ids, stations.size(), 0LL);
+        for (Register& reg : delta_registers) reg.producer_tag = NO_TAG - 1; // Forca a primeira linha
+        delta_rob_head = delta_rob_tail = -1;
+        delta_writes.reserve(machine.commitWidth());
+        writeDeltas(true);
+    }
+    
+    // Completar a janela de busca a partir da fonte. Cada desvio e previsto
+    // ao ser buscado; previsto tomado, a busca continua no alvo.
+    void fetchInstructions() {
+        Instruction instr;
+        while (source && fetch_buffer.size() < fetch_window && source->next(instr)) {
+            instr.id = ++fetched_count;
+            instr.seq = ++fetch_seq;
+            instr.fetch_cycle = current_cycle;
+            if (instr.op == BRANCH) {
+                instr.history = predictor.history();
+                instr.predicted_taken = predictor.predictTaken(instr.pc, instr.target);
+                if (instr.predicted_taken && !predictor.btbHit(instr.pc)) {
+                    instr.predicted_taken = false;
+                    instr.btb_miss = true;
+                }
+                predictor.speculate(instr.predicted_taken);
+                if (instr.predicted_taken) source->jump(instr.target);
+            }
+            fetch_buffer.push_back(instr);
+        }
+    }
+    
+    // Ler operando fonte pela renomeacao: valor arquitetural se nao ha produtor
+    // em voo, valor do ROB se o produtor ja escreveu, senao a tag do produtor.
+    // Operandos que nao sao registradores estao sempre prontos (valor 0).
+    void readOperand(int reg, float& value, int& tag) const {
+        value = 0;
+        tag = NO_TAG;
+        if (reg == NO_REG) return;
+        int producer = registers[reg].producer_tag;
+        if (producer == NO_TAG) {
+            value = registers[reg].value;
+        } else if (rob.value_ready[producer]) {
+            value = rob.value[producer];
+        } else {
+            tag = producer;
+        }
+    }
+    
+    // Emitir instrucao
+    bool issueInstruction() {
+        if (fetch_buffer.empty()) {
+            issue_stall = STALL_FETCH_EMPTY;
+            return false;
+        }
+        if (rob_entries_available == 0) {
+            issue_stall = STALL_ROB_FULL;
+            return false;
+        }
+        
+        const Instruction& instr = fetch_buffer.front();
+        
+        // Hazards RAW/WAW/WAR sao resolvidos pela renomeacao: so ha stall estrutural
+        int station = stations.findFree(stationClassOf(instr.op));
+        if (station == -1) { // Hazard estrutural
+            // A classe e guardada agora: ate o fim do ciclo uma recuperacao
+            // de desvio pode esvaziar e reabastecer a janela de busca
+            issue_stall = STALL_NO_STATION;
+            issue_stall_class = stationClassOf(instr.op);
+            return false;
+        }
+        issue_stall = STALL_NONE;
+        busy_stations[stationClassOf(instr.op)]++;
+        
+        // Alocar entrada no ROB
+        int current_rob_idx = rob_tail;
+        rob.busy[current_rob_idx] = true;
+        rob.instruction_index[current_rob_idx] = instr.id;
+        rob.type[current_rob_idx] = instr.op;
+        rob.state[current_rob_idx] = ROB_ISSUE;
+        rob.value_ready[current_rob_idx] = false; // A entrada pode conter o resultado do ocupante anterior
+        rob.div_by_zero[current_rob_idx] = false;
+        
+        // Configurar destino no ROB; o endereco de LOAD/STORE e calculado
+        // quando a base fica disponivel (resolveMemoryOperands)
+        rob.destination_register[current_rob_idx] = (instr.op != STORE) ? instr.dest : NO_REG;
+        bool memory_op = instr.op == LOAD || instr.op == STORE;
+        if (memory_op) {
+            rob.address[current_rob_idx] = 0;
+            rob.address_ready[current_rob_idx] = false;
+            rob.loaded[current_rob_idx] = false;
+            rob.load_source[current_rob_idx] = -1;
+            (instr.op == LOAD ? load_queue : store_queue).push_back(current_rob_idx);
+        }
+        
+        // Atualizar ponteiros do ROB
+        rob_tail = (rob_tail + 1) % rob_size;
+        rob_entries_available--;
+        
+        // Configurar estação de reserva
+        stations.acquire(station);
+        if (delta_out) delta_station_ids[station] = -1;
+        stations.op[station] = instr.op;
+        stations.instr_id[station] = instr.id;
+        stations.dest[station] = current_rob_idx;  // Tag do ROB como destino
+        stations.dest_reg[station] = rob.destination_register[current_rob_idx];
+        
+        // Configurar operandos usando tags do ROB (antes de renomear o destino,
+        // para que "ADD F1 F1 F2" leia o valor antigo de F1). LOAD/STORE leem a
+        // base do endereco em vj e o STORE, o dado (registrador "destino") em vk.
+        if (memory_op) {
+            readOperand(instr.base_reg, stations.vj[station], stations.qj[station]);
+            readOperand(instr.op == STORE ? instr.dest : NO_REG, stations.vk[station], stations.qk[station]);
+        } else {
+            readOperand(instr.src1, stations.vj[station], stations.qj[station]);
+            readOperand(instr.src2, stations.vk[station], stations.qk[station]);
+        }
+        
+        // Renomear registrador destino
+        if (instr.op != STORE && instr.dest != NO_REG) {
+            // Para instruções que escrevem em registrador
+            registers[instr.dest].producer_tag = current_rob_idx;  // Tag do ROB
+        }
+        
+        // Registrar a estação nas entradas produtoras (wakeup) ou na fila de prontas
+        if (stations.qj[station] != NO_TAG) rob.addConsumer(stations.qj[station], station);
+        if (stations.qk[station] != NO_TAG) rob.addConsumer(stations.qk[station], station);
+        if (stations.operandsReady(station)) {
+            ready_queue.push_back(station);
+        }
+        
+        Instruction& record = rob_instructions[current_rob_idx];
+        int producer_tags[2] = {stations.qj[station], stations.qk[station]};
+        record = instr;
+        record.issue_cycle = current_cycle;
+        for (int k = 0; k < 2; k++) {
+            record.producers[k] = producer_tags[k] != NO_TAG ? rob_instructions[producer_tags[k]].id : 0;
+        }
+        if (memory_op) resolveMemoryOperands(station);
+        fetch_buffer.pop_front();
+        fetchInstructions();
+        
+        return true;
+    }
+    
+    // Executar instrucoes; retorna true se alguma execucao iniciou ou terminou
+    bool executeInstructions() {
+        bool active = false;
+        
+        // Select: iniciar estacoes cujos operandos ficaram prontos numa unidade
+        // funcional livre do tipo da operacao. Com caches, LOAD/STORE tem a
+        // latencia do acesso; sem unidade, sem MSHR livre (ou, no LOAD, sem o
+        // dado do STORE que encaminha o valor) a estacao fica na fila (em
+        // ordem) e tenta de novo no proximo ciclo.
+        size_t waiting = 0;
+        forward_waiting = 0;
+        if (unit_waiting > 0) {
+            for (int kind = 0; kind < NUM_FU_KINDS; kind++) fu_waiting[kind] = 0;
+            unit_waiting = 0;
+        }
+        for (size_t r = 0; r < ready_queue.size(); r++) {
+            int station = ready_queue[r];
+            OpType op = stations.op[station];
+            int unit = units.findFree(fuKindOf(op), current_cycle);
+            if (unit < 0) {
+                ready_queue[waiting++] = station;
+                fu_waiting[fuKindOf(op)]++;
+                unit_waiting++;
+                continue;
+            }
+            int latency = machine.latency(op);
+            if (op == LOAD) {
+                bool forward_wait = false;
+                latency = startLoad(station, forward_wait);
+                forward_waiting += forward_wait;
+            } else if (op == STORE && cache.isEnabled()) {
+                Address address = stations.address[station];
+                latency = memory.contains(address) ? cache.access(address, current_cycle) : cache.hitLatency();
+            }
+            if (latency < 0) {
+                ready_queue[waiting++] = station;
+                continue;
+            }
+            active = true;
+            long long unit_free = units.start(unit, op, latency, current_cycle);
+            Instruction& record = rob_instructions[stations.dest[station]];
+            record.exec_start_cycle = current_cycle;
+            record.state = EXECUTING;
+            executing_count[stationClassOf(op)]++;
+            executing_instructions.push_back(ExecutingInstruction(
+                station,
+                unit,
+                current_cycle + latency - 1,
+                unit_free,
+                stations.instr_id[station],
+                exec_seq++
+            ));
+            push_heap(executing_instructions.begin(), executing_instructions.end(),
+                      greater<ExecutingInstruction>());
+        }
+        ready_queue.resize(waiting);
+        mshr_waiting = static_cast<int>(waiting) - forward_waiting - unit_waiting;
+        
+        // Processar somente as instrucoes que terminam neste ciclo
+        while (!executing_instructions.empty() &&
+               executing_instructions.front().done_cycle <= current_cycle) {
+            pop_heap(executing_instructions.begin(), executing_instructions.end(),
+                     greater<ExecutingInstruction>());
+            int station = executing_instructions.back().station;
+            executing_instructions.pop_back();
+            active = true;
+            OpType op = stations.op[station];
+            float vj = stations.vj[station];
+            float vk = stations.vk[station];
+            Address address = stations.address[station];
+            int dest = stations.dest[station];
+            executing_count[stationClassOf(op)]--;
+            
+            // Instrucao terminou execucao - calcular resultado real (o LOAD
+            // obteve o valor ao iniciar; a divisao por zero e contada no commit)
+            bool div_by_zero = false;
+            float result = op == LOAD ? rob.value[dest]
+                                      : executeOperation(op, vj, vk, address, memory, div_by_zero);
+            rob.div_by_zero[dest] = div_by_zero;
+            
+            rob_instructions[dest].exec_end_cycle = current_cycle;
+            if (op == BRANCH) {
+                bool taken = branchTaken(rob_instructions[dest].cond, vj, vk);
+                result = taken ? 1.0f : 0.0f;
+                if (taken != rob_instructions[dest].predicted_taken) recoverBranch(dest, taken);
+            }
+            
+            // Adicionar ao CDB
+            completed_for_cdb.push_back(CDBEntry(stations.instr_id[station], result, dest));
+            
+            // Liberar a estação
+            releaseStation(station);
+        }
+        return active;
+    }
+    
+    // Imprimir estado atual
+    // Ciclos de execucao que faltam a estacao: a latencia ate iniciar,
+    // done_cycle - current_cycle + 1 executando e 0 esperando o CDB
+    int cyclesLeft(int station) const {
+        for (const auto& exec : executing_instructions) {
+            if (exec.station == station) return static_cast<int>(exec.done_cycle - current_cycle + 1);
+        }
+        bool started = rob_instructions[stations.dest[station]].state != ISSUED;
+        return started ? 0 : machine.latency(stations.op[station]);
+    }
+    
+    void printState() {
+        *out << "\n==================== CICLO " << current_cycle << " ====================" << endl;
+        
+        // Imprimir estações de reserva ADD/SUB
+        *out << "\nEstações de Reserva ADD/SUB:" << endl;
+        *out << setw(8) << "Estação" << setw(8) << "Busy" << setw(8) << "Op" << setw(12) << "Vj" 
+             << setw(12) << "Vk" << setw(12) << "Qj" << setw(12) << "Qk" << setw(10) << "Dest" 
+             << setw(8) << "Ciclos" << endl;
+        *out << string(88, '-') << endl;
+        
+        for (int i = stations.classBegin(ADD_CLASS); i < stations.classBegin(ADD_CLASS + 1); i++) {
+            bool busy = stations.isBusy(i);
+            *out << setw(7) << stations.name(i) << setw(8) << busy << setw(8) 
+                 << stations.op[i] << setw(12) << operandToString(busy, stations.qj[i], stations.vj[i])
+                 << setw(12) << operandToString(busy, stations.qk[i], stations.vk[i])
+                 << setw(12) << tagToString(stations.qj[i]) << setw(12) << tagToString(stations.qk[i]) 
+                 << setw(10) << tagToString(stations.dest[i]) << setw(8) << (busy ? cyclesLeft(i) : 0) << endl;
+        }
+        
+        // Imprimir estações de reserva MUL/DIV
+        *out << "\nEstacoes de Reserva MUL/DIV:\n";
+        *out << setw(8) << "Estacao" << setw(8) << "Busy" << setw(8) << "Op" 
+             << setw(12) << "Vj" << setw(12) << "Vk" << setw(12) << "Qj" 
+             << setw(12) << "Qk" << setw(10) << "Dest" << setw(8) << "Cycles\n";
+        *out << string(88, '-') << "\n";
+        
+        for (int i = stations.classBegin(MULT_CLASS); i < stations.classBegin(MULT_CLASS + 1); i++) {
+            bool busy = stations.isBusy(i);
+            *out << setw(8) << stations.name(i)
+                 << setw(8) << (busy ? "Sim" : "Nao")
+                 << setw(8) << (busy ? opName(stations.op[i]) : "-")
+                 << setw(12) << operandToString(busy, stations.qj[i], stations.vj[i])
+                 << setw(12) << operandToString(busy, stations.qk[i], stations.vk[i])
+                 << setw(12) << tagToString(stations.qj[i])
+                 << setw(12) << tagToString(stations.qk[i])
+                 << setw(10) << (busy ? registerName(stations.dest_reg[i]) : "-")
+                 << setw(8) << (busy ? to_string(cyclesLeft(i)) : "-") << "\n";
+        }
+        
+        // Imprimir estações de reserva LOAD/STORE (Vj: base; Vk: dado do STORE;
+        // endereco "-" ate a base ficar disponivel)
+        *out << "\nEstacoes de Reserva LOAD/STORE:\n";
+        *out << setw(8) << "Estacao" << setw(8) << "Busy" << setw(8) << "Op" 
+             << setw(12) << "Vj" << setw(12) << "Vk" << setw(12) << "Qj" << setw(12) << "Qk"
+             << setw(12) << "Address" << setw(8) << "Cycles\n";
+        *out << string(92, '-') << "\n";
+        
+        for (int i = stations.classBegin(LOAD_CLASS); i < stations.classBegin(STORE_CLASS + 1); i++) {
+            bool busy = stations.isBusy(i);
+            bool resolved = busy && rob.address_ready[stations.dest[i]];
+            *out << setw(8) << stations.name(i)
+                 << setw(8) << (busy ? "Sim" : "Nao")
+                 << setw(8) << (busy ? opName(stations.op[i]) : "-")
+                 << setw(12) << operandToString(busy, stations.qj[i], stations.vj[i])
+                 << setw(12) << (busy && stations.op[i] == STORE
+                                 ? operandToString(busy, stations.qk[i], stations.vk[i]) : "-")
+                 << setw(12) << tagToString(stations.qj[i])
+                 << setw(12) << tagToString(stations.qk[i])
+                 << setw(12) << (resolved ? to_string(stations.address[i]) : "-")
+                 << setw(8) << (busy ? to_string(cyclesLeft(i)) : "-") << "\n";
+        }
+        
+        // Imprimir estado dos registradores
+        *out << "\nEstado dos Registradores:\n";
+        *out << setw(8) << "Reg" << setw(12) << "Valor" << setw(15) << "Produtor" 
+             << setw(8) << "Ready" << setw(8) << "Busy\n";
+        *out << string(51, '-') << "\n";
+        
+        for (int i = 0; i < REGS_PER_BANK; i++) {
+            string reg_name = "F" + to_string(i);
+            auto& reg = registers[REGS_PER_BANK + i];
+            *out << setw(8) << reg_name
+                 << setw(12) << fixed << setprecision(2) << reg.value
+                 << setw(15) << tagToString(reg.producer_tag)
+                 << setw(8) << (reg.ready() ? "Sim" : "Nao")
+                 << setw(8) << (reg.ready() ? "Nao" : "Sim") << "\n";
+        }
+        
+        // Imprimir instrucoes em execucao
+        *out << "\nInstrucoes em Execucao:\n";
+        *out << setw(8) << "ID" << setw(12) << "Estacao" << setw(8) << "Ciclos\n";
+        *out << string(28, '-') << "\n";
+        
+        vector<ExecutingInstruction> in_flight(executing_instructions);
+        sort(in_flight.begin(), in_flight.end(),
+             [](const ExecutingInstruction& a, const ExecutingInstruction& b) { return a.seq < b.seq; });
+        for (const auto& exec : in_flight) {
+            *out << setw(8) << exec.instruction_id
+                 << setw(12) << stations.name(exec.station)
+                 << setw(8) << (exec.done_cycle - current_cycle + 1) << "\n";
+        }
+        
+        // Imprimir conteudo da memoria (apenas posicoes nao-zero das paginas alocadas)
+        *out << "\nConteudo da Memoria (posicoes nao-zero):\n";
+        *out << setw(8) << "Endereco" << setw(12) << "Valor\n";
+        *out << string(20, '-') << "\n";
+        
+        memory.forEachWord(false, [this](Address address, float value) {
+            *out << setw(8) << address
+                 << setw(12) << fixed << setprecision(2) << value << "\n";
+        });
+        
+        // Imprimir estado do ROB
+        *out << "\nReorder Buffer (ROB):" << endl;
+        *out << setw(6) << "ROB#" << setw(6) << "Busy" << setw(8) << "InstIdx" << setw(8) << "Type" 
+             << setw(12) << "State" << setw(8) << "DestReg" << setw(8) << "ValRdy" 
+             << setw(8) << "Value" << setw(8) << "Addr" << endl;
+        *out << string(70, '-') << endl;
+        
+        for (int i = 0; i < rob_size; i++) {
+            if (rob.busy[i]) {
+                *out << setw(6) << i << setw(6) << 1 << setw(8) << rob.instruction_index[i] 
+                     << setw(8) << rob.type[i]  << setw(12) << ROB_STATE_NAMES[rob.state[i]] 
+                     << setw(8) << registerName(rob.destination_register[i]) << setw(8) << int(rob.value_ready[i]) 
+                     << setw(8) << rob.value[i] << setw(8) << rob.address[i] << endl;
+            }
+        }
+        
+        // Imprimir estado da fila CDB
+        *out << "\nCommon Data Bus (CDB):" << endl;
+        *out << setw(8) << "Posicao" << setw(8) << "InstID" << setw(12) << "Valor" << setw(8) << "ROB" << endl;
+        *out << string(36, '-') << endl;
+        
+        for (size_t i = 0; i < completed_for_cdb.size(); i++) {
+            const auto& cdb_entry = completed_for_cdb[i];
+            *out << setw(8) << i << setw(8) << cdb_entry.instr_id << setw(12) << fixed << setprecision(2) 
+                 << cdb_entry.value << setw(8) << cdb_entry.rob_tag << endl;
+        }
+        
+        *out << "\nInstrucoes na janela de busca: " << fetch_buffer.size() << endl;
+        *out << "Instrucoes completadas aguardando CDB: " << completed_for_cdb.size() << endl;
+        *out << "ROB Head: " << rob_head << ", Tail: " << rob_tail 
+             << ", Available: " << rob_entries_available << endl;
+    }
+    
+    // Simular execução
+    void simulate(const SimulationOptions& opts = SimulationOptions()) {
+        options = opts;
+        if (options.critical_path_top > 0) critical_path.init(rob_size, fetch_window);
+        *out << "========== SIMULACAO DO ALGORITMO DE TOMASULO ==========" << endl;
+        
+        while (hasActiveInstructions()) {
+            if (options.max_cycles > 0 && current_cycle > options.max_cycles) {
+                *out << "\nSimulação interrompida (limite de " << options.max_cycles
+                     << " ciclos atingido)" << endl;
+                break;
+            }
+            if (options.checkpoint_at >= 0 && current_cycle > options.checkpoint_at) {
+                // A gravacao aloca; ela fica fora da contagem de --count-allocs
+                alloc_end_count = allocation_count;
+                alloc_end_pages = memory.pageAllocations();
+                string error;
+                if (saveCheckpoint(options.checkpoint_out, error)) {
+                    checkpoint_written = true;
+                    *out << "\nCheckpoint gravado em " << options.checkpoint_out << " ao fim do ciclo "
+                         << current_cycle - 1 << "; simulacao interrompida" << endl;
+                } else {
+                    *out << "\nErro: checkpoint " << options.checkpoint_out << ": " << error << endl;
+                }
+                break;
+            }
+            if (options.alloc_warmup >= 0 && alloc_start_cycle < 0 &&
+                current_cycle > options.alloc_warmup) {
+                alloc_start_cycle = current_cycle;
+                alloc_start_count = allocation_count;
+                alloc_start_pages = memory.pageAllocations();
+            }
+            
+            runCycle();
+        }
+        units.finish(current_cycle);
+        if (!checkpoint_written) {
+            alloc_end_count = allocation_count;
+            alloc_end_pages = memory.pageAllocations();
+        }
+        
+        *out << "\n========== SIMULACAO CONCLUIDA ==========" << endl;
+        printSummary();
+    }
+    
+    // Simular um ciclo (current_cycle) e avancar para o proximo
+    void runCycle() {
+        if (!options.quiet) {
+            *out << "\nProcessando ciclo " << current_cycle << "...\n";
+        }
+        
+        // 1. Commit (ate commit_width instrucoes, em ordem)
+        bool active = false;
+        for (int slot = 0; slot < machine.commitWidth() && commitInstruction(); slot++) {
+            active = true;
+        }
+        
+        // 2. Write-Back (CDB)
+        active |= processWriteBack();
+        
+        // 3. Issue (ate issue_width instrucoes, em ordem; para no primeiro stall)
+        for (int slot = 0; slot < machine.issueWidth() && issue_enabled && issueInstruction(); slot++) {
+            active = true;
+            if (!options.quiet) {
+                *out << "Instrução emitida no ciclo " << current_cycle << "\n";
+            }
+        }
+        
+        // 4. Execute
+        active |= executeInstructions();
+        
+        sampleCycle(1);
+        
+        // 5. Mostrar estado atual
+        if (options.print_interval > 0 && current_cycle % options.print_interval == 0) {
+            printState();
+        }
+        if (delta_out) writeDeltas(false);
+        
+        if (options.skip_idle && !active) {
+            advanceToNextEvent();
+        } else {
+            current_cycle++;
+        }
+    }
+    
+    // Executar ate count instrucoes no modo funcional: cada instrucao le os
+    // registradores arquiteturais, calcula com executeOperation() e escreve o
+    // resultado como o commit faria, sem estacoes, ROB nem ciclos. Exige o
+    // pipeline vazio; consome primeiro a janela de busca. Retorna quantas
+    // instrucoes executou (menos que count no fim do programa).
+    long long fastForward(long long count) {
+        if (pipelineBusy()) return 0;
+        long long done = 0;
+        Instruction instr;
+        while (done < count) {
+            bool fetched = !fetch_buffer.empty();
+            if (fetched) {
+                instr = fetch_buffer.front();
+                fetch_buffer.pop_front();
+            } else if (source && source->next(instr)) {
+                instr.id = ++fetched_count;
+                instr.history = predictor.history();
+            } else {
+                break;
+            }
+            
+            float vj = 0;
+            float vk = 0;
+            Address address = 0;
+            if (instr.op == LOAD || instr.op == STORE) {
+                float base_value = instr.base_reg == NO_REG ? 0 : registers[instr.base_reg].value;
+                address = effectiveAddress(instr.offset, base_value);
+                checkAddress(address, instr.id);
+                if (memory.contains(address)) cache.warm(address);
+                if (instr.op == STORE && instr.dest != NO_REG) vk = registers[instr.dest].value;
+            } else {
+                if (instr.src1 != NO_REG) vj = registers[instr.src1].value;
+                if (instr.src2 != NO_REG) vk = registers[instr.src2].value;
+            }
+            bool div_by_zero = false;
+            float result = executeOperation(instr.op, vj, vk, address, memory, div_by_zero);
+            if (div_by_zero) div_by_zero_count++;
+            if (instr.op == STORE) {
+                memory.write(address, result);
+            } else if (instr.dest != NO_REG) {
+                registers[instr.dest].value = result;
+            }
+            // Desvio: o preditor aprende como no commit. A leitura direta da
+            // fonte segue o resultado; uma instrucao da janela, buscada pela
+            // previsao, descarta o resto da janela se a previsao errou.
+            if (instr.op == BRANCH) {
+                bool taken = branchTaken(instr.cond, vj, vk);
+                predictor.update(instr.pc, instr.history, taken);
+                if (!fetched || taken != instr.predicted_taken) {
+                    fetch_buffer.clear();
+                    predictor.recover(instr.history, taken);
+                    fetched_count = instr.id;
+                    source->jump(taken ? instr.target : instr.pc + 1);
+                }
+            }
+            done++;
+        }
+        functional_count += done;
+        fetchInstructions();
+        return done;
+    }
+    
+    // Modo --functional: o programa inteiro no interpretador funcional
+    void simulateFunctional(const SimulationOptions& opts = SimulationOptions()) {
+        options = opts;
+        *out << "========== EXECUCAO FUNCIONAL ==========" << endl;
+        auto start = chrono::steady_clock::now();
+        long long executed = fastForward(numeric_limits<long long>::max());
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        *out << "Instrucoes executadas: " << executed << "\n";
+        if (div_by_zero_count > 0) {
+            *out << "Divisoes por zero: " << div_by_zero_count << "\n";
+        }
+        if (memory_fault_count > 0) {
+            *out << "Acessos fora da memoria: " << memory_fault_count << "\n";
+        }
+        *out << "Tempo: " << fixed << setprecision(3) << seconds << " s ("
+             << setprecision(1) << (seconds > 0 ? executed / seconds / 1e6 : 0.0) << " milhoes de instrucoes/s)"
+             << endl;
+    }
+    
+    // Simulacao amostrada: alterna avanco funcional (fast_forward instrucoes)
+    // com janelas detalhadas. Cada janela simula warmup instrucoes para encher
+    // estacoes e ROB, mede os ciclos de window instrucoes e esvazia o pipeline
+    // (sem emitir) antes de voltar ao modo funcional. O CPI de cada janela
+    // completa entra na estimativa de SamplingResult.
+    SamplingResult simulateSampled(const SimulationOptions& opts, const SamplingOptions& sampling) {
+        options = opts;
+        *out << "========== SIMULACAO AMOSTRADA ==========" << endl;
+        SamplingResult result;
+        auto start = chrono::steady_clock::now();
+        while (true) {
+            fastForward(sampling.fast_forward);
+            if (!hasActiveInstructions()) break;
+            
+            long long warm_target = committed_count + sampling.warmup;
+            long long end_target = warm_target + sampling.window;
+            long long measure_cycle = -1;
+            long long measure_committed = 0;
+            if (sampling.warmup == 0) {
+                measure_cycle = current_cycle - 1;
+                measure_committed = committed_count;
+            }
+            while (hasActiveInstructions() && committed_count < end_target) {
+                long long cycle = current_cycle;
+                runCycle();
+                if (measure_cycle < 0 && committed_count >= warm_target) {
+                    measure_cycle = cycle;
+                    measure_committed = committed_count;
+                }
+                if (committed_count >= end_target) {
+                    result.window_cpi.push_back(static_cast<double>(cycle - measure_cycle) /
+                                                (committed_count - measure_committed));
+                }
+            }
+            
+            issue_enabled = false;
+            while (pipelineBusy()) runCycle();
+            issue_enabled = true;
+        }
+        result.functional_instructions = functional_count;
+        result.detailed_instructions = committed_count;
+        result.detailed_cycles = cyclesSimulated();
+        result.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        result.print(*out);
+        return result;
+    }
+    
+    // Um ciclo sem commit, broadcast, emissao nem inicio/fim de execucao deixa o
+    // estado inalterado; como nada depende do tempo alem das conclusoes agendadas,
+    // os ciclos seguintes tambem sao ociosos ate a proxima conclusao. Saltar
+    // direto para ela da o mesmo resultado que simular ciclo a ciclo.
+    void advanceToNextEvent() {
+        long long next_cycle = current_cycle + 1;
+        if (!executing_instructions.empty()) {
+            next_cycle = max(next_cycle, executing_instructions.front().done_cycle);
+        }
+        // Nao pular ciclos que devem ser impressos nem o limite de ciclos
+        if (options.print_interval > 0) {
+            long long next_print = (current_cycle / options.print_interval + 1) * options.print_interval;
+            next_cycle = min(next_cycle, next_print);
+        }
+        // Instrucoes esperando MSHR ou unidade funcional podem iniciar quando
+        // um deles liberar
+        if (mshr_waiting > 0) {
+            next_cycle = min(next_cycle, max(current_cycle + 1, cache.nextMshrFree(current_cycle + 1)));
+        }
+        for (int kind = 0; unit_waiting > 0 && kind < NUM_FU_KINDS; kind++) {
+            if (fu_waiting[kind] > 0) {
+                next_cycle = min(next_cycle, units.nextFree(static_cast<FuKind>(kind), current_cycle + 1));
+            }
+        }
+        if (options.max_cycles > 0) {
+            next_cycle = min(next_cycle, options.max_cycles + 1);
+        }
+        if (options.checkpoint_at >= 0) {
+            next_cycle = min(next_cycle, max(current_cycle + 1, options.checkpoint_at + 1));
+        }
+        // Os ciclos saltados repetem o estado (e o motivo de stall) do ciclo ocioso
+        long long skipped = next_cycle - current_cycle - 1;
+        sampleCycle(skipped);
+        idle_cycles_skipped += skipped;
+        current_cycle = next_cycle;
+    }
+    
+    // Acumular as estatisticas do estado ao fim do ciclo, com peso = numero de ciclos
+    void sampleCycle(long long weight) {
+        if (weight <= 0) return;
+        switch (issue_stall) {
+            case STALL_NONE: break;
+            case STALL_FETCH_EMPTY: stats.stall_fetch_empty += weight; break;
+            case STALL_ROB_FULL: stats.stall_rob_full += weight; break;
+            case STALL_NO_STATION:
+                stats.stall_no_station[issue_stall_class] += weight;
+                break;
+        }
+        int rob_occupancy = rob_size - rob_entries_available;
+        stats.rob_occupancy_sum += weight * rob_occupancy;
+        cache.stats.mshr_stall_cycles += weight * mshr_waiting;
+        for (int kind = 0; unit_waiting > 0 && kind < NUM_FU_KINDS; kind++) {
+            units.stats.wait_cycles[kind] += weight * fu_waiting[kind];
+        }
+        stats.lsq.forward_wait_cycles += weight * forward_waiting;
+        stats.rob_occupancy_peak = max(stats.rob_occupancy_peak, rob_occupancy);
+        for (int c = 0; c < NUM_STATION_CLASSES; c++) {
+            stats.station_histogram[c][busy_stations[c]] += weight;
+            stats.executing_cycles[c] += weight * executing_count[c];
+            stats.operand_wait_cycles[c] += weight * (busy_stations[c] - executing_count[c]);
+        }
+    }
+    
+    const SimulationStats& statistics() {
+        stats.cycles = cyclesSimulated();
+        stats.committed = committed_count;
+        stats.cache = cache.stats;
+        stats.fu = units.stats;
+        return stats;
+    }
+    
+    long long cyclesSimulated() const { return current_cycle - 1; }
+    bool checkpointWritten() const { return checkpoint_written; }
+    long long committedInstructions() const { return committed_count; }
+    
+    // Alocacoes entre o fim do aquecimento e o fim da simulacao (modo
+    // --count-allocs), sem as das paginas novas da memoria
+    long long allocationsAfterWarmup() const {
+        return alloc_start_cycle < 0 ? 0 : alloc_end_count - alloc_start_count - pageAllocationsAfterWarmup();
     }
     
-    // Imprimir estado atual
-    void printState() {
-        cout << "\n==================== CICLO " << current_cycle << " ====================" << endl;
-        
-        // Imprimir estações de reserva ADD/SUB
-        cout << "\nEstações de Reserva ADD/SUB:" << endl;
-        cout << setw(8) << "Estação" << setw(8) << "Busy" << setw(8) << "Op" << setw(12) << "Vj" 
-             << setw(12) << "Vk" << setw(12) << "Qj" << setw(12) << "Qk" << setw(10) << "Dest" 
-             << setw(8) << "Ciclos" << endl;
-        cout << string(88, '-') << endl;
-        
-        for (size_t i = 0; i < add_stations.size(); i++) {
-            const auto& station = add_stations[i];
-            cout << setw(7) << "Add" + to_string(i+1) << setw(8) << station.busy << setw(8) 
-                 << station.op << setw(12) << station.vj << setw(12) << station.vk 
-                 << setw(12) << station.qj << setw(12) << station.qk 
-                 << setw(10) << station.dest << setw(8) << station.cycles_left << endl;
+    long long pageAllocationsAfterWarmup() const {
+        return alloc_start_cycle < 0 ? 0 : alloc_end_pages - alloc_start_pages;
+    }
+    
+    // Resumo final da execução
+    void printSummary() {
+        long long cycles = current_cycle - 1;
+        statistics();
+        config.print(*out);
+        *out << "Ciclos simulados: " << cycles << "\n";
+        *out << "Instrucoes commitadas: " << committed_count << "\n";
+        if (options.skip_idle) {
+            *out << "Ciclos ociosos saltados: " << idle_cycles_skipped << "\n";
         }
-        
-        // Imprimir estações de reserva MUL/DIV
-        cout << "\nEstacoes de Reserva MUL/DIV:\n";
-        cout << setw(8) << "Estacao" << setw(8) << "Busy" << setw(8) << "Op" 
-             << setw(12) << "Vj" << setw(12) << "Vk" << setw(12) << "Qj" 
-             << setw(12) << "Qk" << setw(10) << "Dest" << setw(8) << "Cycles\n";
-        cout << string(88, '-') << "\n";
-        
-        for (int i = 0; i < mult_stations.size(); i++) {
-            auto& station = mult_stations[i];
-            cout << setw(8) << ("Mult" + to_string(i + 1))
-                 << setw(8) << (station.busy ? "Sim" : "Nao")
-                 << setw(8) << (station.busy ? (station.op == MUL ? "MUL" : "DIV") : "-")
-                 << setw(12) << (station.vj.empty() ? "-" : station.vj)
-                 << setw(12) << (station.vk.empty() ? "-" : station.vk)
-                 << setw(12) << (station.qj.empty() ? "-" : station.qj)
-                 << setw(12) << (station.qk.empty() ? "-" : station.qk)
-                 << setw(10) << (station.busy ? to_string(station.dest_reg) : "-")
-                 << setw(8) << (station.busy ? to_string(station.cycles_left) : "-") << "\n";
-        }
-        
-        // Imprimir estações de reserva LOAD/STORE
-        cout << "\nEstacoes de Reserva LOAD/STORE:\n";
-        cout << setw(8) << "Estacao" << setw(8) << "Busy" << setw(8) << "Op" 
-             << setw(12) << "Vj" << setw(12) << "Qj" << setw(12) << "Address" 
-             << setw(8) << "Cycles\n";
-        cout << string(68, '-') << "\n";
-        
-        for (int i = 0; i < load_stations.size(); i++) {
-            auto& station = load_stations[i];
-            cout << setw(8) << ("Load" + to_string(i + 1))
-                 << setw(8) << (station.busy ? "Sim" : "Nao")
-                 << setw(8) << (station.busy ? "LOAD" : "-")
-                 << setw(12) << (station.vj.empty() ? "-" : station.vj)
-                 << setw(12) << (station.qj.empty() ? "-" : station.qj)
-                 << setw(12) << (station.busy ? to_string(station.address) : "-")
-                 << setw(8) << (station.busy ? to_string(station.cycles_left) : "-") << "\n";
-        }
-        
-        for (int i = 0; i < store_stations.size(); i++) {
-            auto& station = store_stations[i];
-            cout << setw(8) << ("Store" + to_string(i + 1))
-                 << setw(8) << (station.busy ? "Sim" : "Nao")
-                 << setw(8) << (station.busy ? "STORE" : "-")
-                 << setw(12) << (station.vj.empty() ? "-" : station.vj)
-                 << setw(12) << (station.qj.empty() ? "-" : station.qj)
-                 << setw(12) << (station.busy ? to_string(station.address) : "-")
-                 << setw(8) << (station.busy ? to_string(station.cycles_left) : "-") << "\n";
+        *out << "Stalls de emissao: ROB cheio " << stats.stall_rob_full
+             << ", sem estacao " << stats.stallNoStation()
+             << "; estacoes aguardando operandos (media) " << fixed << setprecision(2)
+             << stats.average(stats.operandWait())
+             << "; ciclos com disputa no CDB: " << stats.cdb_contention_cycles << "\n";
+        if (div_by_zero_count > 0) {
+            *out << "Divisoes por zero: " << div_by_zero_count << "\n";
         }
-        
-        // Imprimir estado dos registradores
-        cout << "\nEstado dos Registradores:\n";
-        cout << setw(8) << "Reg" << setw(12) << "Valor" << setw(15) << "Produtor" 
-             << setw(8) << "Ready" << setw(8) << "Busy\n";
-        cout << string(51, '-') << "\n";
-        
-        for (int i = 0; i < 32; i++) {
-            string reg_name = "F" + to_string(i);
-            auto& reg = registers[reg_name];
-            cout << setw(8) << reg_name
-                 << setw(12) << fixed << setprecision(2) << reg.value
-                 << setw(15) << (reg.producer_tag.empty() ? "-" : reg.producer_tag)
-                 << setw(8) << (reg.ready ? "Sim" : "Nao")
-                 << setw(8) << (reg.busy ? "Sim" : "Nao") << "\n";
+        if (memory_fault_count > 0) {
+            *out << "Acessos fora da memoria: " << memory_fault_count << "\n";
         }
-        
-        // Imprimir instrucoes em execucao
-        cout << "\nInstrucoes em Execucao:\n";
-        cout << setw(8) << "ID" << setw(12) << "Estacao" << setw(8) << "Ciclos\n";
-        cout << string(28, '-') << "\n";
-        
-        for (const auto& exec : executing_instructions) {
-            cout << setw(8) << exec.instruction_id
-                 << setw(12) << exec.station_type
-                 << setw(8) << exec.remaining_cycles << "\n";
+        if (cache.isEnabled()) {
+            const CacheStats& cache_stats = stats.cache;
+            *out << "Cache L1: " << cache_stats.l1_hits << " acertos, " << cache_stats.l1_misses
+                 << " faltas, " << cache_stats.mshr_merges << " faltas secundarias (taxa de acerto "
+                 << fixed << setprecision(2) << 100.0 * stats.l1HitRate() << "%)";
+            if (config.l2_size > 0) {
+                *out << "; L2: " << cache_stats.l2_hits << " acertos, " << cache_stats.l2_misses << " faltas";
+            }
+            *out << "; espera por MSHR: " << cache_stats.mshr_stall_cycles << " instrucao-ciclos\n";
         }
-        
-        // Imprimir conteudo da memoria (apenas posicoes nao-zero)
-        cout << "\nConteudo da Memoria (posicoes nao-zero):\n";
-        cout << setw(8) << "Endereco" << setw(12) << "Valor\n";
-        cout << string(20, '-') << "\n";
-        
-        for (int i = 0; i < memory.size(); i++) {
-            if (memory[i] != 0.0) {
-                cout << setw(8) << i
-                     << setw(12) << fixed << setprecision(2) << memory[i] << "\n";
+        if (config.customUnits()) {
+            *out << "Unidades funcionais:";
+            for (int kind = 0; kind < NUM_FU_KINDS; kind++) {
+                *out << (kind ? ", " : " ") << FU_KIND_NAMES[kind] << " " << units.count(kind)
+                     << (units.isPipelined(kind) ? " pipelined " : " ") << fixed << setprecision(2)
+                     << 100.0 * stats.fuAverageUtilization(kind) << "%";
             }
+            *out << "; espera por unidade livre: " << stats.fu.waitCycles() << " instrucao-ciclos\n";
         }
-        
-        // Imprimir estado do ROB
-        cout << "\nReorder Buffer (ROB):" << endl;
-        cout << setw(6) << "ROB#" << setw(6) << "Busy" << setw(8) << "InstIdx" << setw(8) << "Type" 
-             << setw(12) << "State" << setw(8) << "DestReg" << setw(8) << "ValRdy" 
-             << setw(8) << "Value" << setw(8) << "Addr" << endl;
-        cout << string(70, '-') << endl;
-        
-        for (size_t i = 0; i < rob.size(); i++) {
-            const auto& entry = rob[i];
-            if (entry.busy) {
-                cout << setw(6) << i << setw(6) << entry.busy << setw(8) << entry.instruction_index 
-                     << setw(8) << entry.type << setw(12) << entry.state 
-                     << setw(8) << entry.destination_register << setw(8) << entry.value_ready 
-                     << setw(8) << entry.value << setw(8) << entry.address << endl;
+        if (stats.lsq.loads > 0) {
+            const LsqStats& lsq = stats.lsq;
+            *out << "LSQ: " << lsq.loads << " LOADs, " << lsq.forwards << " encaminhados de STOREs, "
+                 << lsq.speculative_loads << " especulativos; violacoes de ordem: " << lsq.violations
+                 << " (" << lsq.squashed << " instrucoes reexecutadas); espera pelo dado do STORE: "
+                 << lsq.forward_wait_cycles << " instrucao-ciclos\n";
+        }
+        if (stats.branch.branches > 0) {
+            const BranchStats& branch = stats.branch;
+            *out << "Desvios (" << PREDICTOR_NAMES[config.branch_predictor] << "): " << branch.branches
+                 << ", " << branch.taken << " tomados; previsoes erradas: " << branch.mispredictions
+                 << " (" << fixed << setprecision(2) << 100.0 * stats.mispredictRate() << "%), "
+                 << branch.btb_misses << " sem alvo no BTB; caminho errado: " << branch.wrong_path
+                 << " instrucoes descartadas (" << 100.0 * stats.wastedSlots(config)
+                 << "% dos slots de emissao)\n";
+        }
+        if (options.alloc_warmup >= 0) {
+            if (alloc_start_cycle < 0) {
+                *out << "Alocacoes: simulacao terminou antes do fim do aquecimento ("
+                     << options.alloc_warmup << " ciclos)\n";
+            } else {
+                long long measured = current_cycle - alloc_start_cycle;
+                *out << "Alocacoes apos o ciclo " << options.alloc_warmup << ": "
+                     << allocationsAfterWarmup() << " em " << measured << " ciclos ("
+                     << fixed << setprecision(4)
+                     << (measured > 0 ? static_cast<double>(allocationsAfterWarmup()) / measured : 0.0)
+                     << " por ciclo)";
+                if (pageAllocationsAfterWarmup() > 0) {
+                    *out << "; fora da contagem, " << pageAllocationsAfterWarmup()
+                         << " de paginas novas da memoria";
+                }
+                *out << '\n';
             }
         }
-        
-        // Imprimir estado da fila CDB
-        cout << "\nCommon Data Bus (CDB):" << endl;
-        cout << setw(8) << "Posicao" << setw(8) << "InstID" << setw(12) << "Valor" << setw(8) << "ROB" << endl;
-        cout << string(36, '-') << endl;
-        
-        for (size_t i = 0; i < completed_for_cdb.size(); i++) {
-            const auto& cdb_entry = completed_for_cdb[i];
-            cout << setw(8) << i << setw(8) << get<0>(cdb_entry) << setw(12) << fixed << setprecision(2) 
-                 << get<1>(cdb_entry) << setw(8) << get<2>(cdb_entry) << endl;
+        *out << "IPC: " << fixed << setprecision(3)
+             << (cycles > 0 ? static_cast<double>(committed_count) / cycles : 0.0) << endl;
+        if (options.critical_path_top > 0 && !critical_path.empty()) {
+            critical_path.analyze();
+            critical_path.print(*out, options.critical_path_top);
         }
-        
-        cout << "\nInstrucoes na fila: " << instruction_queue.size() << endl;
-        cout << "Instrucoes completadas aguardando CDB: " << completed_for_cdb.size() << endl;
-        cout << "ROB Head: " << rob_head << ", Tail: " << rob_tail 
-             << ", Available: " << rob_entries_available << endl;
     }
     
-    // Simular execução
-    void simulate() {
-        cout << "========== SIMULACAO DO ALGORITMO DE TOMASULO ==========" << endl;
+    // Retorna true se algum resultado foi transmitido
+    bool processWriteBack() {
+        // Cada CDB transmite um resultado por ciclo. Com disputa, "oldest" da
+        // prioridade a entrada mais proxima da cabeca do ROB (a que bloqueia o
+        // commit primeiro); "fifo" segue a ordem de conclusao
+        int broadcasts = min(machine.cdbCount(), static_cast<int>(completed_for_cdb.size()));
+        bool oldest_first = machine.cdbArbitration() == CDB_OLDEST &&
+                            broadcasts < static_cast<int>(completed_for_cdb.size());
+        // Uma violacao de ordem de memoria pode descartar resultados da fila
+        for (int bus = 0; bus < broadcasts && !completed_for_cdb.empty(); bus++) {
+            size_t chosen = 0;
+            if (oldest_first) {
+                int best_age = rob_size;
+                for (size_t i = 0; i < completed_for_cdb.size(); i++) {
+                    int age = robAge(completed_for_cdb[i].rob_tag);
+                    if (age < best_age) {
+                        best_age = age;
+                        chosen = i;
+                    }
+                }
+            }
+            CDBEntry entry = completed_for_cdb[chosen];
+            completed_for_cdb.erase(chosen);
+            broadcastResult(entry);
+        }
+        if (!completed_for_cdb.empty()) {
+            stats.cdb_contention_cycles++;
+            stats.cdb_waiting_results += completed_for_cdb.size();
+        }
+        return broadcasts > 0;
+    }
+    
+    void broadcastResult(const CDBEntry& cdb_entry) {
+        float result = cdb_entry.value;
+        int rob_idx = cdb_entry.rob_tag;
         
-        while (hasActiveInstructions()) {
-            cout << "\nProcessando ciclo " << current_cycle << "..." << endl;
+        if (rob_idx >= 0 && rob_idx < rob_size && rob.busy[rob_idx]) {
+            rob.value[rob_idx] = result;
+            rob.value_ready[rob_idx] = true;
+            rob.state[rob_idx] = ROB_WRITE_RESULT;
+            rob_instructions[rob_idx].write_cycle = current_cycle;
+            rob_instructions[rob_idx].state = WRITE_RESULT;
             
-            // 1. Commit
-            commitInstruction();
+            // O banco de registradores so muda no commit; quem emitir depois
+            // disto le o valor direto do ROB (value_ready)
             
-            // 2. Write-Back (CDB)
-            processWriteBack();
+            // Wakeup: atualizar apenas as estações registradas nesta tag. As de
+            // LOAD/STORE sao anotadas antes, pois o broadcast zera a mascara
+            uint64_t* consumers = rob.consumersOf(rob_idx);
+            memory_wakeups.clear();
+            int memory_begin = stations.classBegin(LOAD_CLASS);
+            int memory_end = stations.classBegin(STORE_CLASS + 1);
+            for (int w = memory_begin >> 6; w << 6 < memory_end; w++) {
+                for (uint64_t pending = consumers[w]; pending; pending &= pending - 1) {
+                    int station = (w << 6) + lowestBit(pending);
+                    if (station >= memory_begin && station < memory_end) memory_wakeups.push_back(station);
+                }
+            }
+            stations.broadcast(rob_idx, result, consumers, ready_queue);
             
-            // 3. Issue
-            if (issueInstruction()) {
-                cout << "Instrução emitida no ciclo " << current_cycle << endl;
+            // Base ou dado recebido: calcular o endereco e conferir a ordem de
+            // memoria (um descarte pode liberar estacoes da lista)
+            for (int station : memory_wakeups) {
+                if (stations.isBusy(station) && resolveMemoryOperands(station)) {
+                    checkMemoryOrder(stations.dest[station]);
+                }
+            }
+        }
+    }
+    
+    // Retorna true se a cabeca do ROB foi commitada
+    bool commitInstruction() {
+        if (rob_entries_available == rob_size || !rob.busy[rob_head]) return false;
+        
+        if (rob.state[rob_head] == ROB_WRITE_RESULT && rob.value_ready[rob_head]) {
+            Instruction& instr = rob_instructions[rob_head];
+            instr.commit_cycle = current_cycle;
+            instr.state = COMMITTED;
+            if (timing_out) {
+                *timing_out << instr.id << ',' << instructionName(instr) << ',' << instr.issue_cycle << ','
+                            << instr.exec_start_cycle << ',' << instr.exec_end_cycle << ','
+                            << instr.write_cycle << ',' << instr.commit_cycle << '\n';
             }
+            if (pipeview_out) writePipeView(instr, true);
+            if (options.critical_path_top > 0) critical_path.record(instr);
             
-            // 4. Execute
-            executeInstructions();
+            if (rob.div_by_zero[rob_head]) {
+                if (!options.quiet) *out << "Erro: Divisao por zero!" << endl;
+                div_by_zero_count++;
+            }
+            if (rob.type[rob_head] == LOAD || rob.type[rob_head] == STORE) {
+                checkAddress(rob.address[rob_head], rob.instruction_index[rob_head]);
+                (rob.type[rob_head] == LOAD ? load_queue : store_queue).pop_front();
+            }
+            if (rob.type[rob_head] == BRANCH) {
+                bool taken = rob.value[rob_head] != 0;
+                predictor.update(instr.pc, instr.history, taken);
+                stats.branch.branches++;
+                stats.branch.taken += taken;
+                stats.branch.mispredictions += instr.mispredicted;
+                stats.branch.btb_misses += instr.btb_miss;
+            }
             
-            // 5. Mostrar estado atual
-            printState();
+            if (rob.type[rob_head] != STORE) {
+                if (rob.destination_register[rob_head] != NO_REG) {
+                    Register& reg = registers[rob.destination_register[rob_head]];
+                    reg.value = rob.value[rob_head];
+                    // Uma escrita posterior pode ter renomeado o registrador de novo:
+                    // a tag so e liberada se esta entrada ainda e a produtora mais recente
+                    if (reg.producer_tag == rob_head) {
+                        reg.producer_tag = NO_TAG;
+                    }
+                }
+            } else {
+                // Unico ponto em que a memoria muda no modo detalhado
+                memory.write(rob.address[rob_head], rob.value[rob_head]);
+                if (delta_out) delta_writes.push_back(make_pair(rob.address[rob_head], rob.value[rob_head]));
+            }
             
-            current_cycle++;
+            committed_count++;
+            if (!options.quiet) {
+                *out << "Ciclo " << current_cycle << ": Commit Inst " 
+                     << rob.instruction_index[rob_head] << " (ROB " << rob_head << ")\n";
+            }
             
-            // Limite de segurança
-            if (current_cycle > 50) {
-                cout << "\nSimulação interrompida (limite de ciclos atingido)" << endl;
-                break;
+            rob.busy[rob_head] = false;
+            rob.state[rob_head] = ROB_EMPTY;
+            rob_head = (rob_head + 1) % rob_size;
+            rob_entries_available++;
+            return true;
+        }
+        return false;
+    }
+    
+    // Liberar estação de reserva ao fim da execução
+    void releaseStation(int station) {
+        busy_stations[stationClassOf(stations.op[station])]--;
+        stations.release(station);
+    }
+    
+private:
+    // Contar (e avisar) o acesso de LOAD/STORE fora da memoria, uma vez por
+    // instrucao ao calcular o endereco; o acesso em si e ignorado pela memoria
+    void checkAddress(Address address, long long instr_id) {
+        if (memory.contains(address)) return;
+        memory_fault_count++;
+        if (!options.quiet) {
+            *out << "Erro: Inst " << instr_id << " acessa o endereco " << address
+                 << " fora da memoria" << endl;
+        }
+    }
+    
+    // Distancia da tag a cabeca do ROB (0 = instrucao mais antiga em voo)
+    int robAge(int tag) const {
+        return (tag - rob_head + rob_size) % rob_size;
+    }
+    
+    // Calcular o endereco de LOAD/STORE assim que a base (vj) fica disponivel
+    // e, no STORE, copiar o dado (vk) para o ROB, de onde e encaminhado aos
+    // LOADs. Retorna true se o endereco de um STORE acabou de ser resolvido.
+    bool resolveMemoryOperands(int station) {
+        int tag = stations.dest[station];
+        bool store_resolved = false;
+        if (stations.qj[station] == NO_TAG && !rob.address_ready[tag]) {
+            Address address = effectiveAddress(rob_instructions[tag].offset, stations.vj[station]);
+            rob.address[tag] = address;
+            rob.address_ready[tag] = true;
+            stations.address[station] = address;
+            store_resolved = stations.op[station] == STORE;
+        }
+        if (stations.op[station] == STORE && stations.qk[station] == NO_TAG && !rob.value_ready[tag]) {
+            rob.value[tag] = stations.vk[station];
+            rob.value_ready[tag] = true;
+        }
+        return store_resolved;
+    }
+    
+    // Iniciar um LOAD. O STORE mais novo entre os mais antigos com o mesmo
+    // endereco encaminha o dado; sem ele o valor vem da memoria (pela cache, se
+    // ligada). STOREs com endereco ainda desconhecido sao ultrapassados
+    // especulativamente e conferidos depois (checkMemoryOrder). Retorna a
+    // latencia, ou -1 se o LOAD deve esperar: pelo dado do STORE (forward_wait)
+    // ou por um MSHR livre.
+    int startLoad(int station, bool& forward_wait) {
+        int tag = stations.dest[station];
+        Address address = rob.address[tag];
+        int age = robAge(tag);
+        int source = NO_TAG;
+        bool speculative = false;
+        if (memory.contains(address)) {
+            for (size_t i = store_queue.size(); i-- > 0;) {
+                int store = store_queue[i];
+                if (robAge(store) > age) continue;
+                if (!rob.address_ready[store]) {
+                    speculative = true;
+                } else if (rob.address[store] == address) {
+                    source = store;
+                    break;
+                }
             }
         }
         
-        cout << "\n========== SIMULACAO CONCLUIDA ==========" << endl;
+        int latency;
+        if (source != NO_TAG) {
+            if (!rob.value_ready[source]) {
+                forward_wait = true;
+                return -1;
+            }
+            latency = cache.isEnabled() ? cache.hitLatency() : machine.latency(LOAD);
+            rob.value[tag] = rob.value[source];
+            rob.load_source[tag] = rob.instruction_index[source];
+            stats.lsq.forwards++;
+        } else {
+            if (!cache.isEnabled()) {
+                latency = machine.latency(LOAD);
+            } else {
+                latency = memory.contains(address) ? cache.access(address, current_cycle) : cache.hitLatency();
+            }
+            if (latency < 0) return -1;
+            rob.value[tag] = memory.read(address);
+            rob.load_source[tag] = -1;
+        }
+        rob.loaded[tag] = true;
+        stats.lsq.loads++;
+        if (speculative) stats.lsq.speculative_loads++;
+        return latency;
+    }
+    
+    // O STORE store acabou de resolver o endereco. Um LOAD mais novo que ja
+    // obteve o valor desse endereco de uma fonte mais antiga que o STORE (a
+    // memoria ou um STORE anterior) leu um valor velho: o mais antigo deles e
+    // todas as instrucoes seguintes sao descartadas e emitidas de novo.
+    void checkMemoryOrder(int store) {
+        Address address = rob.address[store];
+        if (!memory.contains(address)) return;
+        int store_age = robAge(store);
+        long long store_id = rob.instruction_index[store];
+        for (size_t i = 0; i < load_queue.size(); i++) {
+            int load = load_queue[i];
+            if (robAge(load) < store_age || !rob.loaded[load] || rob.address[load] != address) continue;
+            if (rob.load_source[load] < store_id) {
+                stats.lsq.violations++;
+                if (!options.quiet) {
+                    *out << "Ciclo " << current_cycle << ": STORE Inst " << store_id
+                         << " resolveu o endereco " << address << " depois do LOAD Inst "
+                         << rob.instruction_index[load] << "; reexecutando a partir dele\n";
+                }
+                stats.lsq.squashed += squash(robAge(load), true);
+                return;
+            }
+        }
+    }
+    
+    // O desvio na entrada branch do ROB terminou com resultado diferente da
+    // direcao seguida pela busca: as instrucoes mais novas (caminho errado) e a
+    // janela sao descartadas, o historico do preditor e restaurado e a busca
+    // recomeca no caminho correto. O registro do desvio passa a guardar a
+    // direcao correta, para que uma reexecucao (violacao de memoria) nao
+    // recupere de novo o mesmo caminho.
+    void recoverBranch(int branch, bool taken) {
+        Instruction& record = rob_instructions[branch];
+        record.mispredicted = true;
+        record.predicted_taken = taken;
+        stats.branch.recoveries++;
+        stats.branch.wrong_path += squash(robAge(branch) + 1, false);
+        for (size_t i = 0; pipeview_out && i < fetch_buffer.size(); i++) writePipeView(fetch_buffer[i], false);
+        fetch_buffer.clear();
+        predictor.recover(record.history, taken);
+        fetched_count = record.id;
+        source->jump(taken ? record.target : record.pc + 1);
+        fetchInstructions();
+        if (!options.quiet) {
+            *out << "Ciclo " << current_cycle << ": desvio Inst " << record.id << " previsto errado; "
+                 << "busca reiniciada no pc " << (taken ? record.target : record.pc + 1) << "\n";
+        }
     }
     
-    void processWriteBack() {
-        if (completed_for_cdb.empty()) return;
+    // Descartar as entradas do ROB a partir da keep-esima mais antiga (a
+    // contagem, e nao a tag, distingue ROB cheio de vazio): execucoes, prontas,
+    // resultados a espera do CDB e estacoes sao liberados e a renomeacao volta
+    // a apontar para as entradas que ficam. Com refetch as instrucoes voltam,
+    // em ordem, para a frente da janela de busca. Retorna quantas descartou.
+    int squash(int keep, bool refetch) {
+        int tag = (rob_head + keep) % rob_size;
+        int count = rob_size - rob_entries_available - keep;
+        if (count <= 0) return 0;
+        auto squashed = [this, keep](int t) { return robAge(t) >= keep; };
         
-        const auto& cdb_entry = completed_for_cdb.front();
-        int instr_id = get<0>(cdb_entry);
-        float result = get<1>(cdb_entry);
-        string rob_idx_str = get<2>(cdb_entry);
+        size_t kept = 0;
+        for (size_t i = 0; i < executing_instructions.size(); i++) {
+            int station = executing_instructions[i].station;
+            if (squashed(stations.dest[station])) {
+                executing_count[stationClassOf(stations.op[station])]--;
+                units.release(executing_instructions[i].unit, executing_instructions[i].unit_free, current_cycle);
+            } else {
+                executing_instructions[kept++] = executing_instructions[i];
+            }
+        }
+        executing_instructions.erase(executing_instructions.begin() + kept, executing_instructions.end());
+        make_heap(executing_instructions.begin(), executing_instructions.end(),
+                  greater<ExecutingInstruction>());
         
-        completed_for_cdb.erase(completed_for_cdb.begin());
+        kept = 0;
+        for (size_t i = 0; i < ready_queue.size(); i++) {
+            if (!squashed(stations.dest[ready_queue[i]])) ready_queue[kept++] = ready_queue[i];
+        }
+        ready_queue.resize(kept);
         
-        int rob_idx = stoi(rob_idx_str);
-        if (rob_idx >= 0 && rob_idx < rob_size) {
-            ReorderBufferEntry& rob_entry = rob[rob_idx];
-            if (rob_entry.busy) {
-                rob_entry.value = result;
-                rob_entry.value_ready = true;
-                rob_entry.state = "WRITE_RESULT";
-                
-                // Atualizar registradores que dependem deste resultado
-                for (auto& reg : registers) {
-                    if (reg.second.producer_tag == rob_idx_str) {
-                        reg.second.value = result;
-                        reg.second.ready = true;
-                        reg.second.busy = false;
-                        reg.second.producer_tag = "";
-                    }
-                }
-                
-                // Atualizar estações de reserva que dependem deste resultado
-                for (auto& station : getAllStations()) {
-                    if (station->busy) {
-                        if (station->qj == rob_idx_str) {
-                            station->vj = to_string(result);
-                            station->qj = "";
-                        }
-                        if (station->qk == rob_idx_str) {
-                            station->vk = to_string(result);
-                            station->qk = "";
-                        }
-                    }
-                }
-                
-                // Liberar a estação de reserva
-                for (auto& station : getAllStations()) {
-                    if (station->dest == rob_idx_str) {
-                        station->busy = false;
-                        station->instr_id = -1;
-                        station->qj = "";
-                        station->qk = "";
-                        station->vj = "0";
-                        station->vk = "0";
-                        station->address = 0;
-                        station->dest = "";
-                    }
-                }
+        for (size_t i = completed_for_cdb.size(); i-- > 0;) {
+            if (squashed(completed_for_cdb[i].rob_tag)) completed_for_cdb.erase(i);
+        }
+        
+        // Estacoes descartadas saem tambem das mascaras das entradas que esperavam
+        for (int station = 0; station < stations.size(); station++) {
+            if (!stations.isBusy(station) || !squashed(stations.dest[station])) continue;
+            uint64_t bit = 1ULL << (station & 63);
+            if (stations.qj[station] != NO_TAG) rob.consumersOf(stations.qj[station])[station >> 6] &= ~bit;
+            if (stations.qk[station] != NO_TAG) rob.consumersOf(stations.qk[station])[station >> 6] &= ~bit;
+            releaseStation(station);
+        }
+        
+        while (!load_queue.empty() && squashed(load_queue.back())) load_queue.pop_back();
+        while (!store_queue.empty() && squashed(store_queue.back())) store_queue.pop_back();
+        
+        for (int k = 0; pipeview_out && k < count; k++) {
+            writePipeView(rob_instructions[(tag + k) % rob_size], false);
+        }
+        for (int k = count - 1; k >= 0; k--) {
+            int t = (tag + k) % rob_size;
+            if (refetch) {
+                Instruction instr = rob_instructions[t];
+                instr.state = ISSUED;
+                instr.fetch_cycle = current_cycle;
+                instr.issue_cycle = instr.exec_start_cycle = instr.exec_end_cycle = -1;
+                instr.write_cycle = instr.commit_cycle = -1;
+                fetch_buffer.push_front(instr);
             }
+            rob.busy[t] = false;
+            rob.state[t] = ROB_EMPTY;
+            fill(rob.consumersOf(t), rob.consumersOf(t) + rob.consumer_words, uint64_t(0));
+        }
+        rob_tail = tag;
+        rob_entries_available += count;
+        
+        for (int r = 0; r < NUM_REGS; r++) registers[r].producer_tag = NO_TAG;
+        for (int k = 0; k < keep; k++) {
+            int t = (rob_head + k) % rob_size;
+            if (rob.destination_register[t] != NO_REG) registers[rob.destination_register[t]].producer_tag = t;
+        }
+        // As instrucoes buscadas de novo sao outras na linha do tempo: a
+        // janela inteira e renumerada para manter seq em ordem de programa
+        if (refetch) {
+            for (size_t i = 0; i < fetch_buffer.size(); i++) fetch_buffer[i].seq = ++fetch_seq;
+        }
+        return count;
+    }
+    
+    // Um registro O3PipeView: busca (pc, seq e texto da instrucao), etapas
+    // e retirada, em ticks de PIPEVIEW_TICKS_PER_CYCLE por ciclo. Etapas nao
+    // alcancadas e instrucoes descartadas (retired = false) ficam com tick 0.
+    // A emissao para a estacao ocupa decode, rename e dispatch; o inicio da
+    // execucao e issue; a escrita no CDB e complete.
+    void writePipeView(const Instruction& instr, bool retired) {
+        BufferedWriter& trace = *pipeview_out;
+        auto stage = [&trace](const char* name, long long cycle) {
+            trace.putText("O3PipeView:");
+            trace.putText(name);
+            trace.put(':');
+            trace.putInt(cycle > 0 ? cycle * PIPEVIEW_TICKS_PER_CYCLE : 0);
+        };
+        stage("fetch", instr.fetch_cycle);
+        trace.putText(":0x");
+        trace.putHex(static_cast<uint64_t>(instr.pc), 8);
+        trace.putText(":0:");
+        trace.putInt(instr.seq);
+        trace.put(':');
+        writeInstructionText(trace, instr);
+        trace.put('\n');
+        const char* dispatch_stages[] = {"decode", "rename", "dispatch"};
+        for (const char* name : dispatch_stages) {
+            stage(name, instr.issue_cycle);
+            trace.put('\n');
         }
+        stage("issue", instr.exec_start_cycle);
+        trace.put('\n');
+        stage("complete", instr.write_cycle);
+        trace.put('\n');
+        long long retire = retired ? instr.commit_cycle : 0;
+        stage("retire", retire);
+        trace.putText(":store:");
+        trace.putInt(instr.op == STORE && retire > 0 ? retire * PIPEVIEW_TICKS_PER_CYCLE : 0);
+        trace.put('\n');
     }
     
-    void commitInstruction() {
-        if (rob_entries_available == rob_size || !rob[rob_head].busy) return;
+    // Linha de --deltas do ciclo: estacoes alocadas ("alloc"; a emissao
+    // marca a estacao, entao aparece mesmo se ja liberada ou reocupada no
+    // ciclo) e liberadas ("free"), registradores com outra tag ou valor,
+    // STOREs commitados ("mem"; na linha base, as palavras nao nulas da
+    // memoria) e ponteiros do ROB que andaram. O resto e comparado com a
+    // copia da linha anterior; nada e gravado num ciclo sem mudancas.
+    void writeDeltas(bool baseline) {
+        BufferedWriter& json = *delta_out;
+        bool open = false;
+        // Abrir a linha no primeiro campo e cada lista na primeira entrada
+        auto begin = [&]() {
+            if (open) return;
+            json.putText("{\"cycle\":");
+            json.putInt(baseline ? current_cycle - 1 : current_cycle);
+            if (baseline) json.putText(",\"baseline\":true");
+            open = true;
+        };
+        auto field = [&](const char* name, bool& started) {
+            begin();
+            json.putText(started ? "," : ",\"");
+            if (!started) {
+                json.putText(name);
+                json.putText("\":[");
+            }
+            started = true;
+        };
+        auto station = [&](int i) {
+            StationClass c = stations.classOf(i);
+            json.put('"');
+            json.putText(STATION_PREFIXES[c]);
+            json.putInt(i - stations.classBegin(c) + 1);
+            json.put('"');
+        };
         
-        ReorderBufferEntry& head_entry = rob[rob_head];
+        bool allocs = false;
+        for (int i = 0; i < stations.size(); i++) {
+            bool issued = delta_station_ids[i] == -1;
+            if (!issued && (!stations.isBusy(i) || stations.instr_id[i] == delta_station_ids[i])) continue;
+            field("alloc", allocs);
+            json.putText("{\"station\":");
+            station(i);
+            json.putText(",\"id\":");
+            json.putInt(stations.instr_id[i]);
+            json.putText(",\"op\":\"");
+            json.putText(opName(stations.op[i]));
+            json.putText("\",\"rob\":");
+            json.putInt(stations.dest[i]);
+            json.put('}');
+        }
+        if (allocs) json.put(']');
+        bool frees = false;
+        for (int i = 0; i < stations.size(); i++) {
+            long long id = stations.isBusy(i) ? stations.instr_id[i] : 0;
+            if (id == 0 && delta_station_ids[i] != 0) {
+                field("free", frees);
+                station(i);
+            }
+            delta_station_ids[i] = id;
+        }
+        if (frees) json.put(']');
         
-        if (head_entry.state == "WRITE_RESULT" && head_entry.value_ready) {
-            Instruction& instr = all_instructions[head_entry.instruction_index];
-            instr.commit_cycle = current_cycle;
-            
-            if (head_entry.type != STORE) {
-                registers[head_entry.destination_register].value = head_entry.value;
-                registers[head_entry.destination_register].ready = true;
-                registers[head_entry.destination_register].busy = false;
-                registers[head_entry.destination_register].producer_tag = "";
-            } else {
-                if (head_entry.address >= 0 && head_entry.address < memory.size()) {
-                    memory[head_entry.address] = head_entry.value;
-                }
+        bool regs = false;
+        for (int r = 0; r < NUM_REGS; r++) {
+            Register& seen = delta_registers[r];
+            const Register& reg = registers[r];
+            if (reg.producer_tag == seen.producer_tag && memcmp(&reg.value, &seen.value, sizeof(float)) == 0) {
+                continue;
             }
-            
-            cout << "Ciclo " << current_cycle << ": Commit Inst " 
-                 << head_entry.instruction_index << " (ROB " << rob_head << ")" << endl;
-            
-            head_entry.busy = false;
-            head_entry.state = "EMPTY";
-            rob_head = (rob_head + 1) % rob_size;
-            rob_entries_available++;
+            field("regs", regs);
+            json.putText("{\"reg\":\"");
+            json.put(r < REGS_PER_BANK ? 'R' : 'F');
+            json.putInt(r % REGS_PER_BANK);
+            json.putText("\",\"tag\":");
+            if (reg.ready()) json.putText("null");
+            else json.putInt(reg.producer_tag);
+            json.putText(",\"value\":");
+            json.putFloat(reg.value);
+            json.put('}');
+            seen = reg;
+        }
+        if (regs) json.put(']');
+        
+        bool writes = false;
+        auto word = [&](Address address, float value) {
+            field("mem", writes);
+            json.putText("{\"addr\":");
+            json.putInt(address);
+            json.putText(",\"value\":");
+            json.putFloat(value);
+            json.put('}');
+        };
+        // A linha base traz a memoria inicial (--memory-init ou checkpoint)
+        if (baseline) memory.forEachWord(false, word);
+        for (const auto& write : delta_writes) word(write.first, write.second);
+        if (writes) json.put(']');
+        delta_writes.clear();
+        
+        if (rob_head != delta_rob_head || rob_tail != delta_rob_tail) {
+            begin();
+            json.putText(",\"rob\":{\"head\":");
+            json.putInt(rob_head);
+            json.putText(",\"tail\":");
+            json.putInt(rob_tail);
+            json.put('}');
+            delta_rob_head = rob_head;
+            delta_rob_tail = rob_tail;
         }
+        if (open) json.putText("}\n");
     }
     
-    vector<ReservationStation*> getAllStations() {
-        vector<ReservationStation*> all;
-        for (auto& station : add_stations) all.push_back(&station);
-        for (auto& station : mult_stations) all.push_back(&station);
-        for (auto& station : load_stations) all.push_back(&station);
-        for (auto& station : store_stations) all.push_back(&station);
-        return all;
+    bool hasActiveInstructions() {
+        return !fetch_buffer.empty() || pipelineBusy();
     }
     
-private:
-    bool hasActiveInstructions() {
-        return !instruction_queue.empty() || 
-               !executing_instructions.empty() || 
+    // Alguma instrucao emitida e ainda nao commitada
+    bool pipelineBusy() const {
+        return !executing_instructions.empty() || 
+               !ready_queue.empty() || 
                !completed_for_cdb.empty() || 
                rob_entries_available != rob_size;
     }
 };
 
-int main() {
-    TomasuloSimulator simulator;
+// Eixo de uma varredura de parametros: chave da configuracao e valores
+struct SweepAxis {
+    string key;
+    vector<int> values;
+};
+
+// Interpretar "chave=v1,v2,..."
+bool parseSweepAxis(const string& spec, SweepAxis& axis, string& error) {
+    size_t eq = spec.find('=');
+    if (eq == string::npos) {
+        error = "esperado chave=v1,v2,... em '" + spec + "'";
+        return false;
+    }
+    axis.key = MachineConfig::trim(spec.substr(0, eq));
+    axis.values.clear();
     
-    cout << "========== SIMULADOR DO ALGORITMO DE TOMASULO ==========" << endl;
-    cout << "Digite o nome do arquivo de instrucoes: ";
+    MachineConfig probe;
+    stringstream values(spec.substr(eq + 1));
+    string value;
+    while (getline(values, value, ',')) {
+        if (!probe.set(axis.key, MachineConfig::trim(value), error)) return false;
+        axis.values.push_back(*probe.field(axis.key));
+    }
+    if (axis.values.empty()) {
+        error = "nenhum valor para " + axis.key;
+        return false;
+    }
+    return true;
+}
+
+// Resultado de um ponto da varredura
+struct SweepResult {
+    MachineConfig config;
+    string status; // "ok" ou descricao do erro
+    long long cycles;
+    long long committed;
+    SimulationStats stats;
     
-    string filename;
-    getline(cin, filename);
+    SweepResult() : status("ok"), cycles(0), committed(0) {}
+};
+
+// Simular o produto cartesiano dos eixos sobre a configuracao base, com um
+// pool de threads; cada ponto usa sua propria instancia, semente e saida nula.
+// Grava um CSV com os valores dos eixos, ciclos, instrucoes e IPC por ponto.
+bool runSweep(const string& filename, const MachineConfig& base, const vector<SweepAxis>& axes,
+              unsigned seed, int threads, const SimulationOptions& base_options, ostream& csv) {
+    size_t total = 1;
+    for (const SweepAxis& axis : axes) total *= axis.values.size();
+    
+    vector<SweepResult> results(total);
+    for (size_t point = 0; point < total; point++) {
+        // Decodificar o indice do ponto (ultimo eixo varia mais rapido)
+        size_t rest = point;
+        results[point].config = base;
+        for (size_t a = axes.size(); a-- > 0;) {
+            const SweepAxis& axis = axes[a];
+            *results[point].config.field(axis.key) = axis.values[rest % axis.values.size()];
+            rest /= axis.values.size();
+        }
+    }
+    
+    SimulationOptions options = base_options;
+    options.quiet = true;
+    options.print_interval = 0;
+    options.skip_idle = true;
+    
+    atomic<size_t> next_point(0);
+    auto worker = [&]() {
+        ostream null_out(nullptr);
+        for (size_t point = next_point++; point < total; point = next_point++) {
+            SweepResult& result = results[point];
+            string error;
+            if (!result.config.validate(error)) {
+                result.status = error;
+                continue;
+            }
+            TomasuloSimulator<> simulator(result.config, seed, null_out);
+            if (!simulator.loadInstructions(filename)) {
+                result.status = "falha ao abrir " + filename;
+                continue;
+            }
+            simulator.simulate(options);
+            result.cycles = simulator.cyclesSimulated();
+            result.committed = simulator.committedInstructions();
+            result.stats = simulator.statistics();
+        }
+    };
+    
+    auto start = chrono::steady_clock::now();
+    int pool_size = max(1, min(threads, static_cast<int>(total)));
+    vector<thread> pool;
+    for (int t = 0; t < pool_size; t++) pool.emplace_back(worker);
+    for (thread& t : pool) t.join();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    
+    for (const SweepAxis& axis : axes) csv << axis.key << ',';
+    csv << "cycles,instructions,ipc,stall_rob_full,stall_no_station,operand_wait_cycles,"
+        << "cdb_contention_cycles,rob_avg_occupancy,status\n";
+    bool all_ok = true;
+    for (const SweepResult& result : results) {
+        for (const SweepAxis& axis : axes) csv << result.config.valueString(axis.key) << ',';
+        if (result.status == "ok") {
+            double ipc = result.cycles > 0 ? static_cast<double>(result.committed) / result.cycles : 0.0;
+            const SimulationStats& stats = result.stats;
+            csv << result.cycles << ',' << result.committed << ',' << fixed << setprecision(4) << ipc
+                << ',' << stats.stall_rob_full << ',' << stats.stallNoStation() << ',' << stats.operandWait()
+                << ',' << stats.cdb_contention_cycles << ',' << stats.average(stats.rob_occupancy_sum);
+        } else {
+            csv << ",,,,,,,";
+            all_ok = false;
+        }
+        csv << ',' << result.status << '\n';
+    }
+    csv.flush();
+    
+    cerr << total << " pontos simulados em " << fixed << setprecision(2) << seconds
+         << " s com " << pool_size << " threads" << endl;
+    return all_ok;
+}
+
+// Benchmark de escala (--bench): simula o trace com a configuracao base e com
+// estacoes e ROB multiplicados por 4, 16 e 64, medindo o tempo de simulacao
+// por ciclo e por instrucao. Mostra como o custo do laco cresce com o tamanho
+// das estruturas (tabela de estacoes, mascaras de consumidores, ROB).
+bool runBenchmark(const string& filename, const MachineConfig& base, unsigned seed,
+                  const SimulationOptions& base_options, ostream& out) {
+    SimulationOptions options = base_options;
+    options.quiet = true;
+    options.print_interval = 0;
     
-    if (!simulator.loadInstructions(filename)) {
+    out << setw(7) << "Escala" << setw(10) << "Estacoes" << setw(9) << "ROB" << setw(12) << "Ciclos"
+        << setw(12) << "Tempo (s)" << setw(12) << "ns/ciclo" << setw(12) << "ns/instr" << "\n";
+    for (int scale : {1, 4, 16, 64}) {
+        MachineConfig config = base;
+        config.add_stations *= scale;
+        config.mult_stations *= scale;
+        config.load_stations *= scale;
+        config.store_stations *= scale;
+        config.rob_size = min(config.rob_size * scale, 1 << 20);
+        
+        ostream null_out(nullptr);
+        TomasuloSimulator<> simulator(config, seed, null_out);
+        if (!simulator.loadInstructions(filename)) {
+            out << "Erro: Nao foi possivel carregar o arquivo '" << filename << "'\n";
+            return false;
+        }
+        auto start = chrono::steady_clock::now();
+        simulator.simulate(options);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        
+        long long cycles = simulator.cyclesSimulated();
+        long long committed = simulator.committedInstructions();
+        int stations = config.add_stations + config.mult_stations + config.load_stations + config.store_stations;
+        out << setw(6) << scale << "x" << setw(10) << stations << setw(9) << config.rob_size
+            << setw(12) << cycles << fixed << setprecision(3) << setw(12) << seconds << setprecision(1)
+            << setw(12) << (cycles > 0 ? seconds * 1e9 / cycles : 0.0)
+            << setw(12) << (committed > 0 ? seconds * 1e9 / committed : 0.0) << "\n";
+    }
+    return true;
+}
+
+void printInputFormat() {
+    cout << "\nFormato esperado do arquivo:\n";
+    cout << "# Comentarios comecam com #\n";
+    cout << "ADD F1 F2 F3\n";
+    cout << "SUB F4 F1 F5\n";
+    cout << "MUL F6 F2 F4\n";
+    cout << "DIV F7 F6 F3\n";
+    cout << "LOAD F8 0(R1)\n";
+    cout << "STORE F2 4(R2)\n";
+    cout << "laco: SUB R1 R1 R2\n";
+    cout << "BNE R1 R0 laco\n";
+    cout << "\nOperacoes suportadas: ADD, SUB, MUL, DIV, LOAD, STORE e os desvios BEQ, BNE, BLT, BGE\n";
+    cout << "(\"rotulo:\" marca o alvo de um desvio, sozinho na linha ou antes da instrucao)\n";
+    cout << "Tambem e aceito o trace binario gerado por --convert.\n";
+}
+
+void printUsage(const char* program) {
+    cout << "Uso: " << program << " [--trace arquivo] [--max-cycles N] [--print-interval N] [--quiet] [--skip-idle]\n"
+         << "       [--timing-out arquivo] [--pipeview arquivo] [--stats-json arquivo] [--stats-csv arquivo] [--config arquivo] [--set chave=valor]... [--seed N]\n"
+         << "       [--sweep chave=v1,v2,...]... [--threads N] [--sweep-out arquivo] [--count-allocs N] [--bench]\n"
+         << "       [--static] [--checkpoint-at N --checkpoint-out arquivo] [--restore arquivo]\n"
+         << "       [--functional | --sample F,W,D] [--memory-init arquivo] [--memory-dump arquivo]\n"
+         << "       [--critical-path N] [--deltas arquivo]\n";
+    cout << "  --trace arquivo       Arquivo de instrucoes (sem ele, pergunta interativamente)\n";
+    cout << "  --max-cycles N        Interrompe apos N ciclos (padrao: sem limite)\n";
+    cout << "  --print-interval N    Imprime o estado a cada N ciclos (0 = nunca;\n";
+    cout << "                        padrao: 1 no modo interativo, 0 com --trace)\n";
+    cout << "  --quiet               Suprime as mensagens de emissao/commit por ciclo\n";
+    cout << "  --skip-idle           Salta ciclos ociosos direto para o proximo evento\n";
+    cout << "  --timing-out arquivo  Grava em CSV os ciclos de cada instrucao ao ser commitada\n";
+    cout << "  --critical-path N     Caminho critico e espera por instrucao, com as N instrucoes\n";
+    cout << "                        estaticas que mais pesam no caminho\n";
+    cout << "  --deltas arquivo      Grava so o que muda em cada ciclo (estacoes, registradores,\n";
+    cout << "                        memoria, ROB), uma linha JSON por ciclo\n";
+    cout << "  --pipeview arquivo    Grava a linha do tempo de cada instrucao no formato O3PipeView\n";
+    cout << "                        (gem5 o3-pipeview.py, Konata), inclusive as descartadas\n";
+    cout << "  --stats-json arquivo  Grava as estatisticas (stalls, ocupacao, IPC) em JSON\n";
+    cout << "  --stats-csv arquivo   Grava as estatisticas em CSV (metrica,valor)\n";
+    cout << "  --convert txt bin     Compila um arquivo texto para o trace binario e sai\n";
+    cout << "  --config arquivo      Configuracao da maquina (linhas chave = valor)\n";
+    cout << "  --set chave=valor     Sobrescreve uma chave da configuracao (repetivel)\n";
+    cout << "  --seed N              Semente dos valores iniciais dos registradores\n";
+    cout << "  --sweep chave=v1,v2   Varre os valores da chave (repetivel: produto cartesiano)\n";
+    cout << "  --threads N           Threads usadas na varredura (padrao: nucleos disponiveis)\n";
+    cout << "  --sweep-out arquivo   CSV da varredura (padrao: saida padrao)\n";
+    cout << "  --count-allocs N      Conta as alocacoes de memoria apos N ciclos de aquecimento;\n";
+    cout << "                        termina com status 2 se houver alguma\n";
+    cout << "  --bench               Mede o tempo de simulacao do trace com estacoes e ROB\n";
+    cout << "                        multiplicados por 1, 4, 16 e 64 e sai\n";
+    cout << "  --checkpoint-at N     Grava o estado completo ao fim do ciclo N e para\n";
+    cout << "  --checkpoint-out arq  Arquivo do checkpoint gravado por --checkpoint-at\n";
+    cout << "  --restore arquivo     Continua a simulacao a partir de um checkpoint (com a\n";
+    cout << "                        maquina gravada nele; --trace troca o caminho do trace)\n";
+    cout << "  --memory-init arquivo Valores iniciais da memoria (linhas \"endereco valor\")\n";
+    cout << "  --memory-dump arquivo Grava ao fim as palavras nao nulas das paginas modificadas\n";
+    cout << "  --functional          Executa o programa so no interpretador funcional (sem ciclos)\n";
+    cout << "  --sample F,W,D        Simulacao amostrada: F instrucoes funcionais, W de aquecimento\n";
+    cout << "                        e D medidas em detalhe, repetidamente; estima CPI e ciclos\n";
+    cout << "  --static              Usa o simulador compilado para a maquina fixa (configuracao\n";
+    cout << "                        padrao); recusa configuracoes diferentes\n";
+    cout << "                        Chaves:";
+    for (const string& key : MachineConfig::keys()) cout << " " << key;
+    cout << "\n";
+}
+
+// Converter argumento numerico nao-negativo; false se invalido
+bool parseCount(const string& text, long long& value) {
+    if (text.empty()) return false;
+    char* end = nullptr;
+    value = strtoll(text.c_str(), &end, 10);
+    return *end == '\0' && value >= 0;
+}
+
+// Arquivos de entrada e saida de uma simulacao unica (vazio = nao usado)
+struct RunFiles {
+    string restore;     // Checkpoint de partida
+    string memory_init; // Valores iniciais da memoria
+    string timing;
+    string pipeview;    // Linha do tempo O3PipeView
+    string deltas;      // Mudancas de estado por ciclo (JSON lines)
+    string stats_json;
+    string stats_csv;
+    string memory_dump; // Paginas modificadas ao fim
+};
+
+// Simulacao unica (modo interativo ou --trace) com os parametros de Machine.
+// Com files.restore, parte do checkpoint (filename, se dado, substitui o
+// trace gravado nele).
+template <class Machine>
+int runSimulation(const Machine& machine, string filename, unsigned seed, SimulationOptions options,
+                  bool print_interval_set, const RunFiles& files) {
+    TomasuloSimulator<Machine> simulator(machine, seed);
+    MachineConfig config = machine.configuration();
+    
+    if (!files.restore.empty()) {
+        ios::sync_with_stdio(false);
+        if (!print_interval_set) options.print_interval = 0;
+        string error;
+        if (!simulator.restoreCheckpoint(files.restore, filename, error)) {
+            cout << "Erro: checkpoint " << files.restore << ": " << error << "\n";
+            return 1;
+        }
+    } else if (filename.empty()) {
+        cout << "========== SIMULADOR DO ALGORITMO DE TOMASULO ==========" << endl;
+        cout << "Digite o nome do arquivo de instrucoes: ";
+        getline(cin, filename);
+    } else {
+        // Modo batch: sem dump de estado por ciclo, a menos que pedido
+        ios::sync_with_stdio(false);
+        if (!print_interval_set) options.print_interval = 0;
+    }
+    
+    if (files.restore.empty() && !simulator.loadInstructions(filename)) {
         cout << "Erro: Nao foi possivel carregar o arquivo '" << filename << "'\n";
-        cout << "\nFormato esperado do arquivo:\n";
-        cout << "# Comentarios comecam com #\n";
-        cout << "ADD F1 F2 F3\n";
-        cout << "SUB F4 F1 F5\n";
-        cout << "MUL F6 F2 F4\n";
-        cout << "DIV F7 F6 F3\n";
-        cout << "LOAD F8 0(R1)\n";
-        cout << "STORE F2 4(R2)\n";
-        cout << "\nOperacoes suportadas: ADD, SUB, MUL, DIV, LOAD, STORE\n";
+        printInputFormat();
+        return 1;
+    }
+    if (!files.memory_init.empty()) {
+        string error;
+        if (!simulator.initializeMemory(files.memory_init, error)) {
+            cout << "Erro na memoria inicial: " << error << "\n";
+            return 1;
+        }
+    }
+    
+    ofstream timing_file;
+    if (!files.timing.empty()) {
+        timing_file.open(files.timing);
+        if (!timing_file.is_open()) {
+            cout << "Erro: Nao foi possivel criar o arquivo '" << files.timing << "'\n";
+            return 1;
+        }
+        simulator.setTimingOutput(&timing_file);
+    }
+    BufferedWriter pipeview_file;
+    if (!files.pipeview.empty()) {
+        if (!pipeview_file.open(files.pipeview)) {
+            cout << "Erro: Nao foi possivel criar o arquivo '" << files.pipeview << "'\n";
+            return 1;
+        }
+        simulator.setPipeViewOutput(&pipeview_file);
+    }
+    BufferedWriter delta_file;
+    if (!files.deltas.empty()) {
+        if (!delta_file.open(files.deltas)) {
+            cout << "Erro: Nao foi possivel criar o arquivo '" << files.deltas << "'\n";
+            return 1;
+        }
+        simulator.setDeltaOutput(&delta_file);
+    }
+    
+    if (!options.quiet) cout << "Arquivo carregado com sucesso!\n";
+    bool detailed = !options.functional && options.sampling.window == 0;
+    if (options.functional) {
+        simulator.simulateFunctional(options);
+    } else if (options.sampling.window > 0) {
+        simulator.simulateSampled(options, options.sampling);
+    } else {
+        simulator.simulate(options);
+    }
+    if (options.checkpoint_at >= 0 && !simulator.checkpointWritten()) {
+        cout << "Erro: checkpoint nao gravado (a simulacao terminou antes do ciclo "
+             << options.checkpoint_at << ")\n";
+        return 1;
+    }
+    if (!pipeview_file.close()) {
+        cout << "Erro: falha ao gravar '" << files.pipeview << "'\n";
+        return 1;
+    }
+    if (!delta_file.close()) {
+        cout << "Erro: falha ao gravar '" << files.deltas << "'\n";
         return 1;
     }
     
-    cout << "Arquivo carregado com sucesso!\n";
-    simulator.simulate();
+    if (!files.memory_dump.empty()) {
+        ofstream dump(files.memory_dump);
+        if (!dump.is_open()) {
+            cout << "Erro: Nao foi possivel criar o arquivo '" << files.memory_dump << "'\n";
+            return 1;
+        }
+        simulator.dumpMemory(dump);
+    }
+    if (!detailed) return 0;
+    if (!files.stats_json.empty()) {
+        ofstream json(files.stats_json);
+        if (!json.is_open()) {
+            cout << "Erro: Nao foi possivel criar o arquivo '" << files.stats_json << "'\n";
+            return 1;
+        }
+        simulator.statistics().writeJson(json, config);
+    }
+    if (!files.stats_csv.empty()) {
+        ofstream csv(files.stats_csv);
+        if (!csv.is_open()) {
+            cout << "Erro: Nao foi possivel criar o arquivo '" << files.stats_csv << "'\n";
+            return 1;
+        }
+        simulator.statistics().writeCsv(csv, config);
+    }
+    if (options.alloc_warmup >= 0 && simulator.allocationsAfterWarmup() > 0) return 2;
     return 0;
-}
\ No newline at end of file
+}
+
+// "avanco,aquecimento,janela" de --sample
+bool parseSampling(const string& text, SamplingOptions& sampling) {
+    long long* fields[] = {&sampling.fast_forward, &sampling.warmup, &sampling.window};
+    size_t begin = 0;
+    for (int f = 0; f < 3; f++) {
+        size_t end = f < 2 ? text.find(',', begin) : text.size();
+        if (end == string::npos || !parseCount(text.substr(begin, end - begin), *fields[f])) return false;
+        begin = end + 1;
+    }
+    return sampling.window > 0;
+}
+
+int main(int argc, char* argv[]) {
+    SimulationOptions options;
+    MachineConfig config;
+    vector<string> overrides;
+    string config_error;
+    vector<SweepAxis> sweep_axes;
+    string sweep_filename;
+    int threads = max(1u, thread::hardware_concurrency());
+    unsigned seed = static_cast<unsigned>(time(0));
+    string filename;
+    RunFiles files;
+    bool print_interval_set = false;
+    bool bench = false;
+    bool use_static = false;
+    bool config_given = false;
+    
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        long long value = 0;
+        if (arg == "--help" || arg == "-h") {
+            printUsage(argv[0]);
+            return 0;
+        } else if (arg == "--bench") {
+            bench = true;
+        } else if (arg == "--static") {
+            use_static = true;
+        } else if (arg == "--quiet" || arg == "-q") {
+            options.quiet = true;
+        } else if (arg == "--skip-idle") {
+            options.skip_idle = true;
+        } else if (arg == "--trace" && i + 1 < argc) {
+            filename = argv[++i];
+        } else if (arg == "--convert" && i + 2 < argc) {
+            int errors = convertTextTrace(argv[i + 1], argv[i + 2], cout);
+            return errors == 0 ? 0 : 1;
+        } else if (arg == "--config" && i + 1 < argc) {
+            if (!config.loadFile(argv[++i], config_error)) {
+                cout << "Erro na configuracao: " << config_error << "\n";
+                return 1;
+            }
+            config_given = true;
+        } else if (arg == "--set" && i + 1 < argc) {
+            overrides.push_back(argv[++i]);
+        } else if (arg == "--seed" && i + 1 < argc && parseCount(argv[i + 1], value)) {
+            seed = static_cast<unsigned>(value);
+            i++;
+        } else if (arg == "--sweep" && i + 1 < argc) {
+            SweepAxis axis;
+            if (!parseSweepAxis(argv[++i], axis, config_error)) {
+                cout << "Erro na varredura: " << config_error << "\n";
+                return 1;
+            }
+            sweep_axes.push_back(axis);
+        } else if (arg == "--threads" && i + 1 < argc && parseCount(argv[i + 1], value) && value > 0) {
+            threads = static_cast<int>(value);
+            i++;
+        } else if (arg == "--sweep-out" && i + 1 < argc) {
+            sweep_filename = argv[++i];
+        } else if (arg == "--stats-json" && i + 1 < argc) {
+            files.stats_json = argv[++i];
+        } else if (arg == "--stats-csv" && i + 1 < argc) {
+            files.stats_csv = argv[++i];
+        } else if (arg == "--timing-out" && i + 1 < argc) {
+            files.timing = argv[++i];
+        } else if (arg == "--pipeview" && i + 1 < argc) {
+            files.pipeview = argv[++i];
+        } else if (arg == "--deltas" && i + 1 < argc) {
+            files.deltas = argv[++i];
+        } else if (arg == "--checkpoint-at" && i + 1 < argc && parseCount(argv[i + 1], value)) {
+            options.checkpoint_at = value;
+            i++;
+        } else if (arg == "--checkpoint-out" && i + 1 < argc) {
+            options.checkpoint_out = argv[++i];
+        } else if (arg == "--restore" && i + 1 < argc) {
+            files.restore = argv[++i];
+        } else if (arg == "--memory-init" && i + 1 < argc) {
+            files.memory_init = argv[++i];
+        } else if (arg == "--memory-dump" && i + 1 < argc) {
+            files.memory_dump = argv[++i];
+        } else if (arg == "--functional") {
+            options.functional = true;
+        } else if (arg == "--sample" && i + 1 < argc) {
+            if (!parseSampling(argv[++i], options.sampling)) {
+                cout << "Erro: --sample espera avanco,aquecimento,janela (janela > 0)\n";
+                return 1;
+            }
+        } else if (arg == "--critical-path" && i + 1 < argc && parseCount(argv[i + 1], value) && value > 0) {
+            options.critical_path_top = static_cast<int>(value);
+            i++;
+        } else if (arg == "--count-allocs" && i + 1 < argc && parseCount(argv[i + 1], value)) {
+            options.alloc_warmup = value;
+            i++;
+        } else if (arg == "--max-cycles" && i + 1 < argc && parseCount(argv[i + 1], value)) {
+            options.max_cycles = value;
+            i++;
+        } else if (arg == "--print-interval" && i + 1 < argc && parseCount(argv[i + 1], value)) {
+            options.print_interval = static_cast<int>(value);
+            print_interval_set = true;
+            i++;
+        } else {
+            cout << "Argumento invalido: " << arg << "\n";
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    
+    // O checkpoint traz a configuracao da maquina em que foi gravado
+    if (!files.restore.empty()) {
+        if (bench || !sweep_axes.empty()) {
+            cout << "Erro: --restore nao se combina com --bench/--sweep\n";
+            return 1;
+        }
+        if (config_given || !overrides.empty() || !files.memory_init.empty()) {
+            cout << "Erro: --restore usa a configuracao e a memoria gravadas no checkpoint"
+                 << " (sem --config/--set/--memory-init)\n";
+            return 1;
+        }
+        if (options.critical_path_top > 0) {
+            // As instrucoes anteriores ao checkpoint nao foram registradas
+            cout << "Erro: --critical-path nao se combina com --restore\n";
+            return 1;
+        }
+        if (!readCheckpointConfig(files.restore, config, config_error)) {
+            cout << "Erro: checkpoint " << files.restore << ": " << config_error << "\n";
+            return 1;
+        }
+    }
+    if ((options.functional || options.sampling.window > 0) &&
+        (options.checkpoint_at >= 0 || options.functional == (options.sampling.window > 0))) {
+        cout << "Erro: --functional e --sample sao exclusivos e nao gravam checkpoint\n";
+        return 1;
+    }
+    if ((options.functional || options.sampling.window > 0) &&
+        (!files.stats_json.empty() || !files.stats_csv.empty() || options.max_cycles > 0)) {
+        cout << "Erro: --functional e --sample nao gravam --stats-json/--stats-csv"
+             << " nem aceitam --max-cycles\n";
+        return 1;
+    }
+    if ((options.functional || options.sampling.window > 0) &&
+        (options.critical_path_top > 0 || !files.deltas.empty())) {
+        cout << "Erro: --critical-path e --deltas exigem a simulacao detalhada completa"
+             << " (sem --functional/--sample)\n";
+        return 1;
+    }
+    if (options.checkpoint_at >= 0 && options.checkpoint_out.empty()) {
+        cout << "Erro: --checkpoint-at exige --checkpoint-out\n";
+        return 1;
+    }
+    
+    // --set tem precedencia sobre o arquivo, independente da ordem
+    for (const string& assignment : overrides) {
+        if (!config.setAssignment(assignment, config_error)) {
+            cout << "Erro na configuracao: " << config_error << "\n";
+            return 1;
+        }
+    }
+    if (!config.validate(config_error)) {
+        cout << "Erro na configuracao: " << config_error << "\n";
+        return 1;
+    }
+    
+    if (bench) {
+        if (filename.empty()) {
+            cout << "Erro: --bench exige --trace\n";
+            return 1;
+        }
+        return runBenchmark(filename, config, seed, options, cout) ? 0 : 1;
+    }
+    
+    if (!sweep_axes.empty()) {
+        if (filename.empty()) {
+            cout << "Erro: --sweep exige --trace\n";
+            return 1;
+        }
+        ofstream sweep_file;
+        if (!sweep_filename.empty()) {
+            sweep_file.open(sweep_filename);
+            if (!sweep_file.is_open()) {
+                cout << "Erro: Nao foi possivel criar o arquivo '" << sweep_filename << "'\n";
+                return 1;
+            }
+        }
+        ostream& csv = sweep_filename.empty() ? cout : sweep_file;
+        return runSweep(filename, config, sweep_axes, seed, threads, options, csv) ? 0 : 1;
+    }
+    
+    if (use_static) {
+        // A versao compilada so simula a maquina fixa: recusar configuracoes
+        // diferentes em vez de ignora-las silenciosamente
+        MachineConfig fixed = FixedMachine::configuration();
+        for (const string& key : MachineConfig::keys()) {
+            if (config.valueString(key) != fixed.valueString(key)) {
+                cout << "Erro: --static simula apenas a maquina fixa (" << key << " = "
+                     << fixed.valueString(key) << ", pedido " << config.valueString(key) << ")\n";
+                return 1;
+            }
+        }
+        return runSimulation(FixedMachine(), filename, seed, options, print_interval_set, files);
+    }
+    return runSimulation(RuntimeMachine(config), filename, seed, options, print_interval_set, files);
+}